@@ -17,11 +17,27 @@ int main(int argc, char * argv[])
   SDFF_Font font;
   std::string inFileName = Crosy::getExePath() + sourceFontFileName;
   SDFF_Error error = sdff.addFont(inFileName.c_str(), 0, &font);
+  uint64_t buildStartTime = Crosy::getPerformanceCounter();
   error = sdff.addChars(font, '0', '9');
   error = sdff.addChars(font, 'A', 'Z');
   error = sdff.addChars(font, 'a', 'z');
   error = sdff.addChar(font, ' ');
   error = sdff.addChar(font, '\'');
+  uint64_t buildTime = Crosy::getPerformanceCounter() - buildStartTime;
+  printf("Glyphs built in %.1f ms\n", 1000.0 * buildTime / Crosy::getPerformanceFrequency());
+  const std::vector<SDFF_WorkerStats> & workerStats = sdff.workerStats();
+  int taskCount = 0;
+
+  for (int i = 0; i < (int)workerStats.size(); i++)
+    taskCount += workerStats[i].taskCount;
+
+  // a single thread or a short batch builds glyphs one by one without the task scheduler, there is no balance to report
+  for (int i = 0; i < (int)workerStats.size() && taskCount; i++)
+  {
+    const SDFF_WorkerStats & stats = workerStats[i];
+    printf("  worker %d: %d glyphs, %d stolen, %.1f%% busy\n", i, stats.taskCount, stats.stealCount, 100.0f * stats.utilization());
+  }
+
   SDFF_Bitmap textureBitmap;
   sdff.composeTexture(textureBitmap, true);
   
@@ -2,15 +2,26 @@
 
 #include "sdff_bitmap.h"
 
+SDFF_Bitmap::SDFF_Bitmap() :
+  width_(0),
+  height_(0),
+  channels_(1)
+{
+
+}
+
+
 int SDFF_Bitmap::savePNG(const char * fileName)
 {
-  return stbi_write_png(fileName, width_, height_, 1, pixels.data(), 0);
+  return stbi_write_png(fileName, width_, height_, channels_, pixels.data(), 0);
 }
 
 
-void SDFF_Bitmap::resize(int width, int height)
+void SDFF_Bitmap::resize(int width, int height, int channels)
 {
+  assert(channels >= 1 && channels <= 4);
   width_ = width;
   height_ = height;
-  pixels.resize(width * height);
+  channels_ = channels;
+  pixels.resize(width * height * channels);
 }
\ No newline at end of file
@@ -1,11 +1,15 @@
 #pragma once
 
+// 8-bit image with interleaved channels, the distance field modes use 1, MSDF modes 3 or 4 channels,
+// the mono mode with normals 3
 class SDFF_Bitmap
 {
 public:
+  SDFF_Bitmap();
   int width() const { return width_; }
   int height() const { return height_; }
-  void resize(int width, int height);
+  int channels() const { return channels_; }
+  void resize(int width, int height, int channels = 1);
   int savePNG(const char * fileName);
   unsigned char * data() { return pixels.data(); }
   const unsigned char & operator[](int ind) const { return pixels[ind]; }
@@ -14,6 +18,7 @@ public:
 private:
   int width_;
   int height_;
+  int channels_;
   typedef std::vector<unsigned char> SDFF_PixelVector;
   SDFF_PixelVector pixels;
 };
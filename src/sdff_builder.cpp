@@ -11,25 +11,71 @@ SDFF_Builder::SDFF_Builder() :
 
 SDFF_Builder::~SDFF_Builder()
 {
+  releaseWorkers();
   FT_Done_FreeType(ftLibrary_);
 }
 
 
-SDFF_Error SDFF_Builder::init(int sourceFontSize, int sdfFontSize, float falloff)
+SDFF_Error SDFF_Builder::init(int sourceFontSize, int sdfFontSize, float falloff, const SDFF_Options & options)
 {
   assert(sourceFontSize > 0);
   assert(sdfFontSize > 0);
   assert(falloff >= 0);
+  assert(options.threadCount >= 0);
+  assert(options.mode >= SDFF_MODE_MONO_EDT && options.mode <= SDFF_MODE_MONO_SAMPLED);
+  assert(options.filter >= SDFF_FILTER_BOX && options.filter <= SDFF_FILTER_LANCZOS3);
+  assert(options.supersampling >= 1);
+  assert(options.transform >= SDFF_TRANSFORM_MEIJSTER && options.transform <= SDFF_TRANSFORM_BRUTE_FORCE);
+  assert(!options.edgeCorrection || options.transform == SDFF_TRANSFORM_MEIJSTER);
+  assert(!options.normals || (options.mode == SDFF_MODE_MONO_EDT && options.transform == SDFF_TRANSFORM_MEIJSTER));
+  assert(options.oversampling >= 0 && options.minSourceFontSize >= 0 && options.maxSourceFontSize >= 0);
+  assert(options.maxTransformMemory >= 0);
 
   initialized_ = false;
 
-  if (sourceFontSize <= 0 || sdfFontSize <= 0 || falloff < 0)
+  if (sourceFontSize <= 0 || sdfFontSize <= 0 || falloff < 0 || options.threadCount < 0)
     return SDFF_INVALID_VALUE;
 
+  if (options.mode < SDFF_MODE_MONO_EDT || options.mode > SDFF_MODE_MONO_SAMPLED || options.supersampling < 1)
+    return SDFF_INVALID_VALUE;
+
+  if (options.filter < SDFF_FILTER_BOX || options.filter > SDFF_FILTER_LANCZOS3)
+    return SDFF_INVALID_VALUE;
+
+  // only the fused Meijster transform finds the nearest pixels which edge correction measures to
+  if (options.transform < SDFF_TRANSFORM_MEIJSTER || options.transform > SDFF_TRANSFORM_BRUTE_FORCE || (options.edgeCorrection && options.transform != SDFF_TRANSFORM_MEIJSTER))
+    return SDFF_INVALID_VALUE;
+
+  // normals come from the same nearest pixels
+  if (options.normals && (options.mode != SDFF_MODE_MONO_EDT || options.transform != SDFF_TRANSFORM_MEIJSTER))
+    return SDFF_INVALID_VALUE;
+
+  int maxSourceFontSize = options.maxSourceFontSize ? options.maxSourceFontSize : sourceFontSize;
+
+  if (options.oversampling < 0 || options.minSourceFontSize < 0 || options.maxSourceFontSize < 0 || options.minSourceFontSize > maxSourceFontSize || options.maxTransformMemory < 0)
+    return SDFF_INVALID_VALUE;
+
+  int threadCount = options.threadCount ? options.threadCount : glm::max((int)std::thread::hardware_concurrency(), 1);
+  threadPool_.init(threadCount);
+  releaseWorkers();
+  workers_.resize(threadCount);
+  workers_[0].ftLibrary = ftLibrary_;
+
+  // FreeType library and faces are not thread safe, so every worker except the first one has its own library
+  for (int workerIndex = 1; workerIndex < threadCount; workerIndex++)
+    FT_Init_FreeType(&workers_[workerIndex].ftLibrary);
+
+  for (int workerIndex = 0; workerIndex < threadCount; workerIndex++)
+    workers_[workerIndex].transform.reset(SDFF_DistanceTransform::create(options.transform));
+
+  SDFF_SimdLevel cpuSimdLevel = SDFF_Simd::detectLevel();
+  simdLevel_ = options.maxSimdLevel < cpuSimdLevel ? options.maxSimdLevel : cpuSimdLevel;
+  options_ = options;
   sourceFontSize_ = sourceFontSize;
   sdfFontSize_ = sdfFontSize;
   falloff_ = falloff;
   fonts_.clear();
+  appendPackers_.clear();
   maxSrcDfSize_ = 0;
   maxDstDfSize_ = 0;
   initialized_ = true;
@@ -49,26 +95,21 @@ SDFF_Error SDFF_Builder::addFont(const char * fileName, int faceIndex, SDFF_Font
     return SDFF_FONT_ALREADY_EXISTS;
 
   FontData & fontData = fonts_[out_font];
-  FT_Face & ftFace = fontData.ftFace;
+  fontData.fileName = fileName;
+  fontData.faceIndex = faceIndex;
+  fontData.ftFaces.assign(workers_.size(), NULL);
   out_font->falloff_ = falloff_;
 
-  FT_Error ftError;
-  ftError = FT_New_Face(ftLibrary_, fileName, faceIndex, &ftFace);
-  assert(!ftError);
+  SDFF_Error error = openFace(fontData, 0);
 
-  if (ftError)
-    return SDFF_FT_NEW_FACE_ERROR;
-
-  ftError = FT_Set_Char_Size(ftFace, sourceFontSize_ * 64, sourceFontSize_ * 64, 64, 64);
-  assert(!ftError);
-
-  if (ftError)
-    return SDFF_FT_SET_CHAR_SIZE_ERROR;
+  if (error != SDFF_OK)
+    return error;
 
-  static int srcDfSize = sourceFontSize_ * (ftFace->bbox.xMax - ftFace->bbox.xMin) / ftFace->units_per_EM *
-                         sourceFontSize_ * (ftFace->bbox.yMax - ftFace->bbox.yMin) / ftFace->units_per_EM;
-  static int dstDfSize = sdfFontSize_ * (ftFace->bbox.xMax - ftFace->bbox.xMin) / ftFace->units_per_EM *
-                         sdfFontSize_ * (ftFace->bbox.yMax - ftFace->bbox.yMin) / ftFace->units_per_EM;
+  FT_Face ftFace = fontData.ftFaces[0];
+  int srcDfSize = sourceFontSize_ * (ftFace->bbox.xMax - ftFace->bbox.xMin) / ftFace->units_per_EM *
+                  sourceFontSize_ * (ftFace->bbox.yMax - ftFace->bbox.yMin) / ftFace->units_per_EM;
+  int dstDfSize = sdfFontSize_ * (ftFace->bbox.xMax - ftFace->bbox.xMin) / ftFace->units_per_EM *
+                  sdfFontSize_ * (ftFace->bbox.yMax - ftFace->bbox.yMin) / ftFace->units_per_EM;
   maxSrcDfSize_ = glm::max(maxSrcDfSize_, srcDfSize);
   maxDstDfSize_ = glm::max(maxDstDfSize_, dstDfSize);
 
@@ -77,6 +118,53 @@ SDFF_Error SDFF_Builder::addFont(const char * fileName, int faceIndex, SDFF_Font
 
 
 SDFF_Error SDFF_Builder::addChar(SDFF_Font & font, SDFF_Char charCode)
+{
+  return addCharList(font, &charCode, 1);
+}
+
+
+SDFF_Error SDFF_Builder::addChars(SDFF_Font & font, SDFF_Char firstCharCode, SDFF_Char lastCharCode)
+{
+  std::vector<SDFF_Char> charCodes;
+
+  for (SDFF_Char charCode = firstCharCode; charCode <= lastCharCode; charCode++)
+    charCodes.push_back(charCode);
+
+  return addCharList(font, charCodes.data(), (int)charCodes.size());
+}
+
+
+SDFF_Error SDFF_Builder::addChars(SDFF_Font & font, const char * charString)
+{
+  assert(charString);
+
+  if (!charString)
+    return SDFF_INVALID_VALUE;
+
+  // decoding UTF-8, repeated chars are added only once
+  std::vector<SDFF_Char> charCodes;
+  const unsigned char * ptr = (const unsigned char *)charString;
+
+  while (*ptr)
+  {
+    SDFF_Char charCode = *ptr++;
+    int tailLength = charCode >= 0xF0 ? 3 : charCode >= 0xE0 ? 2 : charCode >= 0xC0 ? 1 : 0;
+
+    if (tailLength)
+      charCode &= 0x3F >> tailLength;
+
+    for (; tailLength && (*ptr & 0xC0) == 0x80; tailLength--)
+      charCode = (charCode << 6) | (*ptr++ & 0x3F);
+
+    if (std::find(charCodes.begin(), charCodes.end(), charCode) == charCodes.end())
+      charCodes.push_back(charCode);
+  }
+
+  return addCharList(font, charCodes.data(), (int)charCodes.size());
+}
+
+
+SDFF_Error SDFF_Builder::addCharList(SDFF_Font & font, const SDFF_Char * charCodes, int charCount)
 {
   assert(initialized_);
 
@@ -87,114 +175,369 @@ SDFF_Error SDFF_Builder::addChar(SDFF_Font & font, SDFF_Char charCode)
     return SDFF_FONT_NOT_EXISTS;
 
   FontData & fontData = fonts_[&font];
-  FT_Face & ftFace = fontData.ftFace;
-  CharMap & chars = fontData.chars;
+  int workerCount = (int)workers_.size();
+  std::vector<CharResult> results(charCount);
+
+  // with enough glyphs every worker builds whole glyphs with its own face and scratch,
+  // otherwise glyphs go one by one and the rows of each distance transform are shared between threads instead
+  if (workerCount > 1 && charCount >= 2 * workerCount)
+  {
+    for (int workerIndex = 1; workerIndex < workerCount; workerIndex++)
+    {
+      SDFF_Error error = openFace(fontData, workerIndex);
 
-  if (chars.find(charCode) != chars.end())
+      if (error != SDFF_OK)
+        return error;
+    }
+
+    std::vector<float> costs(charCount);
+
+    for (int i = 0; i < charCount; i++)
+      costs[i] = estimateCharCost(fontData.ftFaces[0], charCodes[i]);
+
+    threadPool_.runTasks(charCount, costs.data(), [&](int taskIndex, int threadIndex)
+    {
+      results[taskIndex].error = buildChar(fontData, threadIndex, charCodes[taskIndex], false, results[taskIndex]);
+    });
+  }
+  else
+  {
+    for (int i = 0; i < charCount; i++)
+      results[i].error = buildChar(fontData, 0, charCodes[i], true, results[i]);
+  }
+
+  // results are committed in the requested order, so font metadata does not depend on the thread count
+  for (int i = 0; i < charCount; i++)
+  {
+    if (results[i].error != SDFF_OK)
+      return results[i].error;
+
+    commitChar(font, fontData, charCodes[i], results[i]);
+  }
+
+  return SDFF_OK;
+}
+
+
+// Distance transform and downsampling are linear in the padded source bitmap area,
+// so the area estimated from unhinted outline metrics is used as the glyph cost.
+// Outline mode visits every segment at every texel, so the area is weighted by the outline size.
+float SDFF_Builder::estimateCharCost(FT_Face ftFace, SDFF_Char charCode) const
+{
+  // adaptive sizes scale the area of the glyph rendered at the fixed size, the size loads the glyph unscaled
+  float sizeScale = float(glyphSourceSize(ftFace, charCode)) / sourceFontSize_;
+  FT_Error ftError = FT_Load_Char(ftFace, (const FT_UInt)charCode, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP | FT_LOAD_IGNORE_TRANSFORM);
+
+  if (ftError || !ftFace->glyph->metrics.width || !ftFace->glyph->metrics.height)
+    return 1.0f;
+
+  float srcFalloff = falloff_ * sourceFontSize_;
+  float srcWidth = (float(ftFace->glyph->metrics.width) / 64 + 2 * srcFalloff) * sizeScale;
+  float srcHeight = (float(ftFace->glyph->metrics.height) / 64 + 2 * srcFalloff) * sizeScale;
+
+  if (outlineMode())
+    return srcWidth * srcHeight * glm::max((int)ftFace->glyph->outline.n_points, 1);
+
+  return srcWidth * srcHeight;
+}
+
+
+// Render size of a glyph in the raster modes. With oversampling set, the size is the smallest one giving that many
+// source pixels per texel along both axes of the padded glyph, instead of the ratio of the common size to sdfFontSize.
+// Texel counts of a glyph round up, so the size is scaled by the rounding of the tighter axis, which matters most for small glyphs.
+int SDFF_Builder::glyphSourceSize(FT_Face ftFace, SDFF_Char charCode) const
+{
+  if (options_.oversampling <= 0 || outlineMode())
+    return sourceFontSize_;
+
+  int minSize = glm::max(options_.minSourceFontSize, 1);
+  int maxSize = options_.maxSourceFontSize ? options_.maxSourceFontSize : sourceFontSize_;
+  float texelScale = 1.0f;
+
+  // unscaled metrics are in font units, the same for any size set on the face
+  FT_Error ftError = FT_Load_Char(ftFace, (const FT_UInt)charCode, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP | FT_LOAD_IGNORE_TRANSFORM);
+
+  if (!ftError && ftFace->glyph->metrics.width && ftFace->glyph->metrics.height)
+  {
+    float width = (float(ftFace->glyph->metrics.width) / ftFace->units_per_EM + 2 * falloff_) * sdfFontSize_;
+    float height = (float(ftFace->glyph->metrics.height) / ftFace->units_per_EM + 2 * falloff_) * sdfFontSize_;
+    texelScale = glm::max(glm::ceil(width) / width, glm::ceil(height) / height);
+  }
+
+  int size = (int)glm::ceil(options_.oversampling * sdfFontSize_ * texelScale);
+
+  return glm::clamp(size, minSize, maxSize);
+}
+
+
+SDFF_Error SDFF_Builder::buildChar(FontData & fontData, int workerIndex, SDFF_Char charCode, bool parallelRows, CharResult & result)
+{
+  if (fontData.chars.find(charCode) != fontData.chars.end())
     return SDFF_CHAR_ALREADY_EXISTS;
 
-  FT_Error ftError = FT_Load_Char(ftFace, (const FT_UInt)charCode, FT_LOAD_DEFAULT | FT_LOAD_IGNORE_TRANSFORM | FT_LOAD_RENDER | FT_LOAD_TARGET_MONO | FT_LOAD_FORCE_AUTOHINT);
+  Worker & worker = workers_[workerIndex];
+  FT_Face ftFace = fontData.ftFaces[workerIndex];
+  SDFF_Bitmap & charBitmap = result.bitmap;
+
+  FT_Int32 loadFlags = FT_LOAD_DEFAULT | FT_LOAD_IGNORE_TRANSFORM | FT_LOAD_FORCE_AUTOHINT;
+
+  // outline modes keep the hinted outline of the raster modes, but skip rendering
+  if (outlineMode())
+    loadFlags |= FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_MONO;
+  else
+    loadFlags |= FT_LOAD_RENDER | (options_.mode == SDFF_MODE_AA_EDT ? FT_LOAD_TARGET_NORMAL : FT_LOAD_TARGET_MONO);
+
+  // raster modes render every glyph at its own size, the face gets back the common size before returning
+  int sourceSize = glyphSourceSize(ftFace, charCode);
+
+  if (sourceSize != sourceFontSize_ && FT_Set_Char_Size(ftFace, sourceSize * 64, sourceSize * 64, 64, 64))
+    return SDFF_FT_SET_CHAR_SIZE_ERROR;
+
+  FT_Error ftError = FT_Load_Char(ftFace, (const FT_UInt)charCode, loadFlags);
   assert(!ftError);
 
-  if (ftError)
+  if (sourceSize != sourceFontSize_ && FT_Set_Char_Size(ftFace, sourceFontSize_ * 64, sourceFontSize_ * 64, 64, 64))
     return SDFF_FT_SET_CHAR_SIZE_ERROR;
 
-  SDFF_Bitmap & charBitmap = chars[charCode];
+  if (ftError)
+    return SDFF_FT_SET_CHAR_SIZE_ERROR;
 
-  if (ftFace->glyph->bitmap.width && ftFace->glyph->bitmap.rows)
+  if (outlineMode())
   {
+    SDFF_Error error = createOutlineBitmap(ftFace->glyph, worker, charBitmap);
 
-    static DistanceFieldVector srcSdf;
-    static DistanceFieldVector destSdf;
-    srcSdf.reserve(maxSrcDfSize_);
+    if (error != SDFF_OK)
+      return error;
+  }
+  else if (ftFace->glyph->bitmap.width && ftFace->glyph->bitmap.rows)
+  {
+    DistanceFieldVector & destSdf = worker.destSdf;
     destSdf.reserve(maxDstDfSize_);
-    int srcFalloff = int(falloff_ * sourceFontSize_);
-    createSdf(ftFace->glyph->bitmap, srcFalloff, srcSdf);
-
+    int srcFalloff = int(falloff_ * sourceSize);
+    const FT_Bitmap & ftBitmap = ftFace->glyph->bitmap;
     int srcWidth = ftFace->glyph->bitmap.width + 2 * srcFalloff;
     int srcHeight = ftFace->glyph->bitmap.rows + 2 * srcFalloff;
-    float fontScale = (float)sdfFontSize_ / sourceFontSize_;
+    float fontScale = (float)sdfFontSize_ / sourceSize;
     int destWidth = (int)glm::ceil(srcWidth * fontScale);
     int destHeight = (int)glm::ceil(srcHeight * fontScale);
     float horzScale = float(destWidth) / srcWidth;
     float vertScale = float(destHeight) / srcHeight;
-    float horzOpScale = 1.0f / horzScale;
-    float vertOpScale = 1.0f / vertScale;
+
+    // filtered fields are sums weighted by source pixel area, sampled ones are averages
+    float valueScale = horzScale * vertScale;
     destSdf.assign(destWidth * destHeight, 0.0f);
 
-    for (int y = 0; y < srcHeight; y++)
-    for (int x = 0; x < srcWidth; x++)
+    if (options_.mode == SDFF_MODE_MONO_SAMPLED)
     {
-      int srcIndex = x + y * srcWidth;
-
-      float destLeftf = x * horzScale;
-      float destRightf = (x + 1) * horzScale;
-      float destTopf = y * vertScale;
-      float destBottomf = (y + 1) * vertScale;
+      // a texel sample is the distance of a single pixel, which saturates at the saturation distance itself
+      int band = (int)glm::ceil(glm::max(srcFalloff * 128.0f / 127.0f, srcFalloff + 1.0f)) + 1;
+      worker.sampled.init(ftBitmap, srcFalloff, band);
+      const SDFF_SampledSdf & sampled = worker.sampled;
+      valueScale = 1.0f;
 
-      int destLefti = (int)destLeftf;
-      int destRighti = (int)destRightf;
-      int destTopi = (int)destTopf;
-      int destBottomi = (int)destBottomf;
-
-      if (destLefti == destRighti || destRighti >= destWidth)
+      if (parallelRows)
       {
-        if (destTopi == destBottomi || destBottomi >= destHeight)
-        {
-          int destIndex = destLefti + destTopi * destWidth;
-          destSdf[destIndex] += srcSdf[srcIndex];
-        }
-        else
+        threadPool_.parallelFor(destHeight, 1, [&](int firstRow, int lastRow, int)
         {
-          float topChunk = (destBottomi - destTopf) * vertOpScale;
-          float bottomChunk = (destBottomf - destBottomi) * vertOpScale;
-          int destIndex0 = destLefti + destTopi * destWidth;
-          int destIndex1 = destLefti + destBottomi * destWidth;
-          destSdf[destIndex0] += topChunk * srcSdf[srcIndex];
-          destSdf[destIndex1] += bottomChunk * srcSdf[srcIndex];
-        }
+          sampled.createSdf(destWidth, destHeight, options_.supersampling, firstRow, lastRow, destSdf.data());
+        });
       }
       else
+        sampled.createSdf(destWidth, destHeight, options_.supersampling, 0, destHeight, destSdf.data());
+    }
+    else if (options_.mode == SDFF_MODE_AA_EDT || options_.transform != SDFF_TRANSFORM_MEIJSTER)
+    {
+      const SDFF_Resampler & horzResampler = resampler(worker, srcWidth, destWidth);
+      const SDFF_Resampler & vertResampler = resampler(worker, srcHeight, destHeight);
+
+      // the coverage transform and the mono engines other than the fused one need the whole field,
+      // only they keep a full resolution one
+      DistanceFieldVector & srcSdf = worker.srcSdf;
+      int tileRows = srcHeight;
+      int band = narrowBand(srcFalloff, horzResampler, vertResampler);
+      int margin = 0;
+
+      // Over the memory limit the field is transformed in bands of rows, each with margin rows of its neighbors on both sides.
+      // Rows beyond the margin are background to the transform, which only moves distances already longer than the margin,
+      // so the rows of a band clamped to the narrow band are the same as in the whole field. Approximate transforms
+      // propagate distances through neighbors and get twice the margin, so a path to the nearest edge never crosses a cut.
+      if (options_.maxTransformMemory && band)
       {
-        if (destTopi == destBottomi || destBottomi >= destHeight)
-        {
-          float leftChunk = (destRighti - destLeftf) * horzOpScale;
-          float rightChunk = (destRightf - destRighti) * horzOpScale;
-          int destIndex0 = destLefti + destTopi * destWidth;
-          int destIndex1 = destRighti + destTopi * destWidth;
-          destSdf[destIndex0] += leftChunk * srcSdf[srcIndex];
-          destSdf[destIndex1] += rightChunk * srcSdf[srcIndex];
-        }
+        bool exact = options_.mode == SDFF_MODE_MONO_EDT && SDFF_DistanceTransform::isExact(options_.transform);
+        int pixelBytes = options_.mode == SDFF_MODE_AA_EDT ? SDFF_EdtAA::pixelBytes() : worker.transform->pixelBytes();
+        int memoryRows = int(options_.maxTransformMemory * 1048576.0 / ((double)srcWidth * pixelBytes));
+        margin = exact ? band : 2 * band;
+        // below a margin of rows per band the limit is exceeded rather than transforming the margins over and over
+        tileRows = glm::min(glm::max(memoryRows - 2 * margin, margin), srcHeight);
+      }
+      else
+        srcSdf.reserve(maxSrcDfSize_);
+
+      worker.resampledRow.resize(destWidth);
+
+      for (int tileRow = 0; tileRow < srcHeight; tileRow += tileRows)
+      {
+        int tileEnd = glm::min(tileRow + tileRows, srcHeight);
+        int firstRow = glm::max(tileRow - margin, 0);
+        int rowCount = glm::min(tileEnd + margin, srcHeight) - firstRow;
+
+        if (options_.mode == SDFF_MODE_AA_EDT)
+          worker.edtAA.createSdf(ftBitmap.buffer, ftBitmap.width, ftBitmap.rows, ftBitmap.pitch, srcFalloff, band, firstRow, rowCount, srcSdf);
         else
+          worker.transform->createSdf(ftBitmap, srcFalloff, band, firstRow, rowCount, srcSdf);
+
+        for (int y = tileRow; y < tileEnd; y++)
         {
-          float leftChunk = (destRighti - destLeftf) * horzOpScale;
-          float rightChunk = (destRightf - destRighti) * horzOpScale;
-          float topChunk = (destBottomi - destTopf) * vertOpScale;
-          float bottomChunk = (destBottomf - destBottomi) * vertOpScale;
-          int destIndex00 = destLefti + destTopi * destWidth;
-          int destIndex10 = destRighti + destTopi * destWidth;
-          int destIndex01 = destLefti + destBottomi * destWidth;
-          int destIndex11 = destRighti + destBottomi * destWidth;
-          destSdf[destIndex00] += leftChunk * topChunk * srcSdf[srcIndex];
-          destSdf[destIndex10] += rightChunk * topChunk * srcSdf[srcIndex];
-          destSdf[destIndex01] += leftChunk * bottomChunk * srcSdf[srcIndex];
-          destSdf[destIndex11] += rightChunk * bottomChunk * srcSdf[srcIndex];
+          float * row = srcSdf.data() + (y - firstRow) * srcWidth;
+
+          if (tileRows < srcHeight)
+          {
+            for (int x = 0; x < srcWidth; x++)
+              row[x] = glm::clamp(row[x], -(float)band, (float)band);
+          }
+
+          downsampleRow(row, y, horzResampler, vertResampler, 0, destHeight, worker.resampledRow.data(), destSdf.data());
         }
       }
     }
+    else
+    {
+      const SDFF_Resampler & horzResampler = resampler(worker, srcWidth, destWidth);
+      const SDFF_Resampler & vertResampler = resampler(worker, srcHeight, destHeight);
+      int band = narrowBand(srcFalloff, horzResampler, vertResampler);
+      FeatureVector * features = options_.normals ? &worker.features : NULL;
+      createSdf(ftBitmap, srcFalloff, band, horzResampler, vertResampler, worker.edt, parallelRows, destSdf, features);
+
+      if (features)
+        createNormals(ftBitmap, srcFalloff, *features, horzResampler, vertResampler, worker.edt, parallelRows, worker.normals);
+    }
 
-    charBitmap.resize(destWidth, destHeight);
-    float sqScale = horzScale * vertScale;
+    int channels = bitmapChannels();
+    charBitmap.resize(destWidth, destHeight, channels);
 
     for (int y = 0; y < destHeight; y++)
     for (int x = 0; x < destWidth; x++)
     {
       int ind = x + y * destWidth;
-      charBitmap[ind] = (unsigned char)glm::clamp(128 - int(destSdf[ind] * sqScale * 127 / srcFalloff), 0, 255);
+      charBitmap[ind * channels] = (unsigned char)glm::clamp(128 - int(destSdf[ind] * valueScale * 127 / srcFalloff), 0, 255);
+
+      // averaged normals are shorter where the edge turns, only their direction is kept
+      if (options_.normals)
+      {
+        glm::vec2 normal(worker.normals[ind], worker.normals[ind + destWidth * destHeight]);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : normal;
+        charBitmap[ind * channels + 1] = (unsigned char)(128 + int(glm::round(normal.x * 127)));
+        charBitmap[ind * channels + 2] = (unsigned char)(128 + int(glm::round(normal.y * 127)));
+      }
     }
   }
   else charBitmap.resize(0, 0);
-  
+
+  result.glyph.bearingX = float(ftFace->glyph->metrics.horiBearingX) / 64 / sourceSize;
+  result.glyph.bearingY = float(ftFace->glyph->metrics.horiBearingY) / 64 / sourceSize;
+  result.glyph.advance = float(ftFace->glyph->metrics.horiAdvance) / 64 / sourceSize;
+  result.glyph.width = float(ftFace->glyph->metrics.width) / 64 / sourceSize;
+  result.glyph.height = float(ftFace->glyph->metrics.height) / 64 / sourceSize;
+
+  return SDFF_OK;
+}
+
+
+// A dest texel averages source pixels which are at most its footprint diagonal apart, and the signed distance
+// changes by no more than that plus one pixel at the edge. Once any of them is farther than the saturation
+// distance plus that, all of them saturate, so clamping source distances there leaves the output unchanged.
+// Filters with negative weights can leave the saturated range, so they get no band (0).
+int SDFF_Builder::narrowBand(int srcFalloff, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler) const
+{
+  if (!options_.narrowBand || !SDFF_Resampler::isPositive(options_.filter))
+    return 0;
+
+  float footprint = glm::length(glm::vec2((float)horzResampler.span(), (float)vertResampler.span()));
+  float saturation = glm::max(srcFalloff * 128.0f / 127.0f, srcFalloff + 1.0f);
+
+  // corrected distances are up to half a pixel diagonal shorter
+  return (int)glm::ceil(saturation + footprint) + (options_.edgeCorrection ? 3 : 2);
+}
+
+
+// Builds the glyph bitmap on the same texel grid as the downsampled raster modes
+const SDFF_Resampler & SDFF_Builder::resampler(Worker & worker, int srcSize, int destSize)
+{
+  // glyphs share most of their sizes (cap height, digit width), so tables are built once per worker
+  std::pair<int, int> key(srcSize, destSize);
+  ResamplerMap::iterator it = worker.resamplers.find(key);
+
+  if (it == worker.resamplers.end())
+  {
+    it = worker.resamplers.insert(std::make_pair(key, SDFF_Resampler())).first;
+    it->second.init(srcSize, destSize, options_.filter);
+  }
+
+  return it->second;
+}
+
+
+SDFF_Error SDFF_Builder::createOutlineBitmap(FT_GlyphSlot ftGlyph, Worker & worker, SDFF_Bitmap & charBitmap)
+{
+  assert(ftGlyph->format == FT_GLYPH_FORMAT_OUTLINE);
+
+  if (ftGlyph->format != FT_GLYPH_FORMAT_OUTLINE)
+    return SDFF_FT_LOAD_CHAR_ERROR;
+
+  const FT_Glyph_Metrics & metrics = ftGlyph->metrics;
+
+  if (!metrics.width || !metrics.height)
+  {
+    charBitmap.resize(0, 0, bitmapChannels());
+    return SDFF_OK;
+  }
+
+  if (!worker.outline.decompose(ftGlyph->outline))
+    return SDFF_FT_LOAD_CHAR_ERROR;
+
+  // the same box as the FreeType rasterizer uses for the bitmap
+  FT_BBox cbox;
+  FT_Outline_Get_CBox(&ftGlyph->outline, &cbox);
+  int pixelLeft = int(cbox.xMin >> 6);
+  int pixelRight = int((cbox.xMax + 63) >> 6);
+  int pixelBottom = int(cbox.yMin >> 6);
+  int pixelTop = int((cbox.yMax + 63) >> 6);
+
+  int srcFalloff = int(falloff_ * sourceFontSize_);
+  int srcWidth = pixelRight - pixelLeft + 2 * srcFalloff;
+  int srcHeight = pixelTop - pixelBottom + 2 * srcFalloff;
+  float fontScale = (float)sdfFontSize_ / sourceFontSize_;
+  int destWidth = (int)glm::ceil(srcWidth * fontScale);
+  int destHeight = (int)glm::ceil(srcHeight * fontScale);
+  float left = float(pixelLeft - srcFalloff);
+  float top = float(pixelTop + srcFalloff);
+  // quantized values saturate beyond this distance
+  float maxDistance = srcFalloff * 128.0f / 127.0f + 1.0f;
+  DistanceFieldVector & destSdf = worker.destSdf;
+  int channels = bitmapChannels();
+
+  if (channels > 1)
+    worker.outline.createMsdf(left, top, float(srcWidth) / destWidth, float(srcHeight) / destHeight, destWidth, destHeight, maxDistance, channels, destSdf);
+  else
+    worker.outline.createSdf(left, top, float(srcWidth) / destWidth, float(srcHeight) / destHeight, destWidth, destHeight, maxDistance, destSdf);
+
+  charBitmap.resize(destWidth, destHeight, channels);
+
+  for (int i = 0; i < destWidth * destHeight * channels; i++)
+    charBitmap[i] = (unsigned char)glm::clamp(128 - int(destSdf[i] * 127 / srcFalloff), 0, 255);
+
+  return SDFF_OK;
+}
+
+
+void SDFF_Builder::commitChar(SDFF_Font & font, FontData & fontData, SDFF_Char charCode, CharResult & result)
+{
+  FT_Face ftFace = fontData.ftFaces[0];
+  CharMap & chars = fontData.chars;
+  FT_Error ftError;
+  chars[charCode] = result.bitmap;
+
   if (chars.size() > 1)
   {
     for (CharMap::iterator charIt = chars.begin(); charIt != chars.end(); ++charIt)
@@ -226,415 +569,307 @@ SDFF_Error SDFF_Builder::addChar(SDFF_Font & font, SDFF_Char charCode)
     }
   }
   SDFF_Glyph & glyph = font.glyphs_[charCode];
-  glyph.bearingX = float(ftFace->glyph->metrics.horiBearingX) / 64 / sourceFontSize_;
-  glyph.bearingY = float(ftFace->glyph->metrics.horiBearingY) / 64 / sourceFontSize_;
-  glyph.advance = float(ftFace->glyph->metrics.horiAdvance) / 64 / sourceFontSize_;
-  glyph.width = float(ftFace->glyph->metrics.width) / 64 / sourceFontSize_;
-  glyph.height = float(ftFace->glyph->metrics.height) / 64 / sourceFontSize_;
+  glyph.bearingX = result.glyph.bearingX;
+  glyph.bearingY = result.glyph.bearingY;
+  glyph.advance = result.glyph.advance;
+  glyph.width = result.glyph.width;
+  glyph.height = result.glyph.height;
   font.maxBearingY_ = glm::max(font.maxBearingY_, glyph.bearingY);
   font.maxHeight_ = glm::max(font.maxHeight_, glyph.height);
 
-  return SDFF_OK;
 }
 
 
-SDFF_Error SDFF_Builder::addChars(SDFF_Font & font, SDFF_Char firstCharCode, SDFF_Char lastCharCode)
+SDFF_Error SDFF_Builder::openFace(FontData & fontData, int workerIndex)
 {
-  for (SDFF_Char charCode = firstCharCode; charCode <= lastCharCode; charCode++)
-  {
-    SDFF_Error error = addChar(font, charCode);
+  FT_Face & ftFace = fontData.ftFaces[workerIndex];
 
-    if (error != SDFF_OK)
-      return error;
+  if (ftFace)
+    return SDFF_OK;
+
+  FT_Error ftError;
+  ftError = FT_New_Face(workers_[workerIndex].ftLibrary, fontData.fileName.c_str(), fontData.faceIndex, &ftFace);
+  assert(!ftError);
+
+  if (ftError)
+  {
+    ftFace = NULL;
+    return SDFF_FT_NEW_FACE_ERROR;
   }
 
+  ftError = FT_Set_Char_Size(ftFace, sourceFontSize_ * 64, sourceFontSize_ * 64, 64, 64);
+  assert(!ftError);
+
+  if (ftError)
+    return SDFF_FT_SET_CHAR_SIZE_ERROR;
+
   return SDFF_OK;
 }
 
 
-SDFF_Error SDFF_Builder::addChars(SDFF_Font & font, const char * charString)
+void SDFF_Builder::releaseWorkers()
 {
+  // faces are released together with their libraries, the first worker uses the builder library
+  for (int workerIndex = 1; workerIndex < (int)workers_.size(); workerIndex++)
+    FT_Done_FreeType(workers_[workerIndex].ftLibrary);
 
-  return SDFF_OK;
+  workers_.clear();
 }
 
 
-struct Rect
-{
-  int left;
-  int top;
-  int width;
-  int height;
-  SDFF_Font * font;
-  SDFF_Char charCode;
-
-  int bottom() const { return top + height - 1; }
-  int right() const { return left + width - 1; }
-  bool intersect(const Rect & rect) const { return rect.left < left + width && rect.left + rect.width > left && rect.top < top + height && rect.top + rect.height > top; }
-  bool contain(int x, int y) const { return x >= left && x < left + width && y >= top && y < top + height; }
-  bool fitIn(const Rect & rect) const { return rect.width >= width && rect.height >= height; }
-  bool operator ==(const Rect & rect) const { return rect.left == left && rect.top == top && rect.width == width && rect.height == height; }
-};
-
-template<>
-struct std::hash<Rect>
+SDFF_Error SDFF_Builder::composeTexture(SDFF_Bitmap & bitmap, bool powerOfTwo, SDFF_Packing packing)
 {
-  std::size_t operator()(const Rect & rect) const
-  {
-    return hash<uint64_t>()(
-      (uint64_t(rect.left & 0xFFFF)) << 48 |
-      (uint64_t(rect.top & 0xFFFF)) << 32 |
-      (uint64_t(rect.width & 0xFFFF)) << 16 |
-      (uint64_t(rect.height & 0xFFFF)) << 0);
-  }
-};
+  std::vector<SDFF_Bitmap> pages;
+  SDFF_Error error = composeTexture(pages, powerOfTwo, INT_MAX, INT_MAX, packing);
+
+  if (error == SDFF_OK)
+    std::swap(bitmap, pages[0]);
 
-SDFF_Error SDFF_Builder::composeTexture(SDFF_Bitmap & bitmap, bool powerOfTwo)
+  return error;
+}
+
+
+SDFF_Error SDFF_Builder::composeTexture(std::vector<SDFF_Bitmap> & pages, bool powerOfTwo, int maxPageWidth, int maxPageHeight, SDFF_Packing packing)
 {
   assert(initialized_);
+  assert(packing >= SDFF_PACKING_FREE_RECTS && packing <= SDFF_PACKING_DENSEST);
+  assert(maxPageWidth > 0 && maxPageHeight > 0);
 
   if (!initialized_)
     return SDFF_NOT_INITIALIZED;
 
-  typedef std::multimap<int, Rect> CharRectMap;
-  typedef std::unordered_set<Rect> FreeRectSet;
-  typedef std::vector<FreeRectSet::iterator> EraseVector;
-  typedef std::vector<Rect> InsertVector;
-  CharRectMap charRects;
-  FreeRectSet freeRects;
-  EraseVector eraseVector;
-  InsertVector insertVector;
-  eraseVector.reserve(1024);
-  insertVector.reserve(1024);
-
-  // add all our char rects into the array
+  if (packing < SDFF_PACKING_FREE_RECTS || packing > SDFF_PACKING_DENSEST || maxPageWidth <= 0 || maxPageHeight <= 0)
+    return SDFF_INVALID_VALUE;
+
+  // the glyphs move, so the pages of appendTexture start over
+  appendPackers_.clear();
+
   for (FontMap::iterator fontIt = fonts_.begin(); fontIt != fonts_.end(); ++fontIt)
+    fontIt->second.appendedChars.clear();
+
+  std::vector<CharKey> charKeys;
+  SDFF_Packer::RectVector charRects;
+  listChars(false, charKeys, charRects);
+
+  // a power of two page is at most the largest power of two within the limits
+  int binWidth = maxPageWidth;
+  int binHeight = maxPageHeight;
+
+  if (powerOfTwo)
   {
-    CharMap & chars = fontIt->second.chars;
+    binWidth = firstPowerOfTwoGreaterThen(binWidth) > (unsigned int)binWidth ? firstPowerOfTwoGreaterThen(binWidth) / 2 : binWidth;
+    binHeight = firstPowerOfTwoGreaterThen(binHeight) > (unsigned int)binHeight ? firstPowerOfTwoGreaterThen(binHeight) / 2 : binHeight;
+  }
 
-    for (CharMap::iterator charIt = chars.begin(); charIt != chars.end(); ++charIt)
-    {
-      int width = charIt->second.width();
-      int height = charIt->second.height();
-      Rect charRect = { 0, 0, width, height, fontIt->first, charIt->first };
-      charRects.insert(std::make_pair(width * height, charRect));
-    }
+  for (size_t i = 0; i < charRects.size(); i++)
+  {
+    if (charRects[i].width > binWidth || charRects[i].height > binHeight)
+      return SDFF_INVALID_VALUE;
   }
 
-  // statring with one free very big rect
-  freeRects.insert({ 0, 0, INT_MAX, INT_MAX });
-  int maxRight = 0;
-  int maxBottom = 0;
+  std::unique_ptr<SDFF_Packer> packer(SDFF_Packer::create(packing, &threadPool_));
+  std::vector<int> charPages(charRects.size(), 0);
+  int pageCount = 1;
+  int width;
+  int height;
+  packer->pack(charRects, powerOfTwo, width, height);
 
-  // enumerating all chars
-  for (CharRectMap::reverse_iterator charRectIt = charRects.rbegin(); charRectIt != charRects.rend(); ++charRectIt)
+  if (powerOfTwo)
   {
-    if (!charRectIt->second.width || !charRectIt->second.height)
-      continue;
-
-    char cc = charRectIt->second.charCode;
+    width = firstPowerOfTwoGreaterThen(glm::max(width, 1));
+    height = firstPowerOfTwoGreaterThen(glm::max(height, 1));
+  }
 
-    // find best fit free rect for placing our char
-    Rect & charRect = charRectIt->second;
-    const Rect * bestRectPtr = NULL;
-    float bestEstimator = FLT_MAX;
+  // over the page size the glyphs fill bins of the page size one by one, a page takes the glyphs left by the previous ones
+  if (width > maxPageWidth || height > maxPageHeight)
+  {
+    PackerVector pagePackers;
+    insertIntoPages(pagePackers, packing, binWidth, binHeight, charRects, charPages, width, height);
+    pageCount = (int)pagePackers.size();
 
-    // for each char searching for most appropriate free rect using estimator
-    for (FreeRectSet::iterator freeRectIt = freeRects.begin(); freeRectIt != freeRects.end(); ++freeRectIt)
+    if (powerOfTwo)
     {
-      freeRects;
-      const Rect & freeRect = *freeRectIt;
-
-      if (charRect.fitIn(freeRect))
-      {
-        int thisRight = freeRect.left + charRect.width;
-        int thisBottom = freeRect.top + charRect.height;
-        int thisMaxRight = glm::max(maxRight, thisRight);
-        int thisMaxBottom = glm::max(maxBottom, thisBottom);
-        int minBounds = glm::max(thisMaxRight, thisMaxBottom);
-        int minLeftTop = (freeRect.left + freeRect.top);
-        float thisEstimator = 10.0f * minBounds + 0.1f * minLeftTop;
-
-        if (thisEstimator < bestEstimator)
-        {
-          bestEstimator = thisEstimator;
-          bestRectPtr = &freeRect;
-        }
-      }
+      width = firstPowerOfTwoGreaterThen(glm::max(width, 1));
+      height = firstPowerOfTwoGreaterThen(glm::max(height, 1));
     }
+  }
 
-    assert(bestRectPtr);
-
-    if (bestRectPtr)
-    {
-      // placing char into selected best free rect
-      charRect.left = bestRectPtr->left;
-      charRect.top = bestRectPtr->top;
-      maxRight = glm::max(maxRight, charRect.left + charRect.width);
-      maxBottom = glm::max(maxBottom, charRect.top + charRect.height);
+  width = glm::max(width, 1);
+  height = glm::max(height, 1);
+  pages.assign(pageCount, SDFF_Bitmap());
 
-      eraseVector.clear();
-      insertVector.clear();
+  for (int page = 0; page < pageCount; page++)
+    pages[page].resize(width, height, bitmapChannels());
 
-      // excluding char rect from any free rects that intersects with it
-      for (FreeRectSet::iterator freeRectIt = freeRects.begin(); freeRectIt != freeRects.end(); ++freeRectIt)
-      {
-        const Rect & freeRect = *freeRectIt;
+  for (size_t i = 0; i < charRects.size(); i++)
+  {
+    const SDFF_Packer::Rect & charRect = charRects[i];
+    SDFF_Font * font = charKeys[i].first;
+    SDFF_Char charCode = charKeys[i].second;
+    SDFF_Glyph & glyph = font->glyphs_[charCode];
+    glyph.left = float(charRect.left) / width;
+    glyph.right = float(charRect.right() + 1) / width;
+    glyph.top = float(charRect.top) / height;
+    glyph.bottom = float(charRect.bottom() + 1) / height;
+    glyph.page = charPages[i];
+
+    copyBitmap(fonts_[font].chars[charCode], pages[charPages[i]], charRect.left, charRect.top);
+  }
 
-        if (charRect.intersect(freeRect))
-        {
-          bool leftTopIn = freeRect.contain(charRect.left, charRect.top);
-          bool leftBottomIn = freeRect.contain(charRect.left, charRect.bottom());
-          bool rightTopIn = freeRect.contain(charRect.right(), charRect.top);
-          bool rightBottomIn = freeRect.contain(charRect.right(), charRect.bottom());
-          int vertexInCount = (int)leftTopIn + (int)leftBottomIn + (int)rightTopIn + (int)rightBottomIn;
+  return SDFF_OK;
+}
 
-          if (vertexInCount == 0)
-          {
-            bool leftSideCross = charRect.left >= freeRect.left && charRect.left <= freeRect.right();
-            bool rightSideCross = charRect.right() >= freeRect.left && charRect.right() <= freeRect.right();
-            bool topSideCross = charRect.top >= freeRect.top && charRect.top <= freeRect.bottom();
-            bool bottomSideCross = charRect.bottom() >= freeRect.top && charRect.bottom() <= freeRect.bottom();
-            int crossCount = (int)leftSideCross + (int)rightSideCross + (int)topSideCross + (int)bottomSideCross;
 
-            if (crossCount == 1)
-            {
-              Rect newRect = freeRect;
+SDFF_Error SDFF_Builder::appendTexture(std::vector<SDFF_Bitmap> & pages, int pageWidth, int pageHeight, std::vector<SDFF_DirtyRect> & dirtyRects)
+{
+  assert(initialized_);
+  assert(pageWidth > 0 && pageHeight > 0);
+  assert(appendPackers_.empty() || (pageWidth == appendPageWidth_ && pageHeight == appendPageHeight_ && pages.size() == appendPackers_.size()));
 
-              if (leftSideCross)
-                newRect.width = charRect.left - newRect.left;
-              else if (topSideCross)
-                newRect.height = charRect.top - newRect.top;
-              else if (rightSideCross)
-              {
-                int dLeft = charRect.left + charRect.width - newRect.left;
-                newRect.left += dLeft;
-                newRect.width -= dLeft;
-              }
-              else if (bottomSideCross)
-              {
-                int dTop = charRect.top + charRect.height - newRect.top;
-                newRect.top += dTop;
-                newRect.height -= dTop;
-              }
-              else assert(0);
+  if (!initialized_)
+    return SDFF_NOT_INITIALIZED;
 
-              if (newRect.width && newRect.height)
-                insertVector.push_back(newRect);
-            }
-            else if (crossCount == 2)
-            {
-              Rect newRect1 = freeRect;
-              Rect newRect2 = freeRect;
-              
-              if (leftSideCross) // and respectively rightSideCross
-              {
-                newRect1.width = charRect.left - newRect1.left;
-                int dLeft = charRect.left + charRect.width - newRect2.left;
-                newRect2.left += dLeft;
-                newRect2.width -= dLeft;
-              }
-              else if (topSideCross) // and respectively bottomSideCross
-              {
-                newRect1.height = charRect.top - newRect1.top;
-                int dTop = charRect.top + charRect.height - newRect2.top;
-                newRect2.top += dTop;
-                newRect2.height -= dTop;
-              }
-              else assert(0);
+  if (pageWidth <= 0 || pageHeight <= 0)
+    return SDFF_INVALID_VALUE;
 
-              if (newRect1.width && newRect1.height)
-                insertVector.push_back(newRect1);
+  if (!appendPackers_.empty() && (pageWidth != appendPageWidth_ || pageHeight != appendPageHeight_ || pages.size() != appendPackers_.size()))
+    return SDFF_INVALID_VALUE;
 
-              if (newRect2.width && newRect2.height)
-                insertVector.push_back(newRect2);
-            }
-            else assert(0);
+  std::vector<CharKey> charKeys;
+  SDFF_Packer::RectVector charRects;
+  listChars(true, charKeys, charRects);
 
-          }
-          else if(vertexInCount == 1)
-          {
-            Rect newRect1 = freeRect;
-            Rect newRect2 = freeRect;
-            
-            if (leftTopIn)
-            {
-              newRect1.height = charRect.top - newRect1.top;
-              newRect2.width = charRect.left - newRect2.left;
+  for (size_t i = 0; i < charRects.size(); i++)
+  {
+    if (charRects[i].width > pageWidth || charRects[i].height > pageHeight)
+      return SDFF_INVALID_VALUE;
+  }
 
-              if (newRect1.height)
-                insertVector.push_back(newRect1);
+  if (appendPackers_.empty())
+  {
+    pages.clear();
+    appendPageWidth_ = pageWidth;
+    appendPageHeight_ = pageHeight;
+  }
 
-              if (newRect2.width)
-                insertVector.push_back(newRect2);
-            }
-            else if (leftBottomIn)
-            {
-              newRect1.width = charRect.left - newRect1.left;
-              int dTop = charRect.top + charRect.height - newRect2.top;
-              newRect2.top += dTop;
-              newRect2.height -= dTop;
-            }
-            else if (rightTopIn)
-            {
-              newRect1.height = charRect.top - newRect1.top;
-              int dLeft = charRect.left + charRect.width - newRect2.left;
-              newRect2.left += dLeft;
-              newRect2.width -= dLeft;
-            }
-            else if (rightBottomIn)
-            {
-              int dLeft = charRect.left + charRect.width - newRect1.left;
-              newRect1.left += dLeft;
-              newRect1.width -= dLeft;
-              int dTop = charRect.top + charRect.height - newRect2.top;
-              newRect2.top += dTop;
-              newRect2.height -= dTop;
-            }
-            else assert(0);
+  std::vector<int> charPages(charRects.size(), 0);
+  int maxRight;
+  int maxBottom;
+  insertIntoPages(appendPackers_, SDFF_PACKING_FREE_RECTS, pageWidth, pageHeight, charRects, charPages, maxRight, maxBottom);
 
-            if (newRect1.width && newRect1.height)
-              insertVector.push_back(newRect1);
+  while (pages.size() < appendPackers_.size())
+  {
+    pages.push_back(SDFF_Bitmap());
+    pages.back().resize(pageWidth, pageHeight, bitmapChannels());
+  }
 
-            if (newRect2.width && newRect2.height)
-              insertVector.push_back(newRect2);
-          }
-          else if (vertexInCount == 2)
-          {
-            bool leftSideIn = leftTopIn && leftBottomIn;
-            bool topSideIn = leftTopIn && rightTopIn;
-            bool rightSideIn = rightTopIn && rightBottomIn;
-            bool bottomSideIn = leftBottomIn && rightBottomIn;
-            Rect newRect1 = freeRect;
-            Rect newRect2 = freeRect;
-            Rect newRect3 = freeRect;
-            
-            if (leftSideIn)
-            {
-              newRect1.width = charRect.left - newRect1.left;
-              newRect2.height = charRect.top - newRect2.top;
-              int dTop = charRect.top + charRect.height - newRect3.top;
-              newRect3.top += dTop;
-              newRect3.height -= dTop;
-            }
-            else if (topSideIn)
-            {
-              newRect1.width = charRect.left - newRect1.left;
-              newRect2.height = charRect.top - newRect2.top;
-              int dLeft = charRect.left + charRect.width - newRect3.left;
-              newRect3.left += dLeft;
-              newRect3.width -= dLeft;
-            }
-            else if (rightSideIn)
-            {
-              newRect1.height = charRect.top - newRect1.top;
-              int dLeft = charRect.left + charRect.width - newRect2.left;
-              newRect2.left += dLeft;
-              newRect2.width -= dLeft;
-              int dTop = charRect.top + charRect.height - newRect3.top;
-              newRect3.top += dTop;
-              newRect3.height -= dTop;
-            }
-            else if (bottomSideIn)
-            {
-              newRect1.width = charRect.left - newRect1.left;
-              int dLeft = charRect.left + charRect.width - newRect2.left;
-              newRect2.left += dLeft;
-              newRect2.width -= dLeft;
-              int dTop = charRect.top + charRect.height - newRect3.top;
-              newRect3.top += dTop;
-              newRect3.height -= dTop;
-            }
-            else assert(0);
+  dirtyRects.clear();
 
-            if (newRect1.width && newRect1.height)
-              insertVector.push_back(newRect1);
+  for (size_t i = 0; i < charRects.size(); i++)
+  {
+    const SDFF_Packer::Rect & charRect = charRects[i];
+    SDFF_Font * font = charKeys[i].first;
+    SDFF_Char charCode = charKeys[i].second;
+    SDFF_Glyph & glyph = font->glyphs_[charCode];
+    glyph.left = float(charRect.left) / pageWidth;
+    glyph.right = float(charRect.right() + 1) / pageWidth;
+    glyph.top = float(charRect.top) / pageHeight;
+    glyph.bottom = float(charRect.bottom() + 1) / pageHeight;
+    glyph.page = charPages[i];
+    fonts_[font].appendedChars.insert(charCode);
+
+    if (charRect.width && charRect.height)
+    {
+      SDFF_DirtyRect dirtyRect = { charPages[i], charRect.left, charRect.top, charRect.width, charRect.height };
+      dirtyRects.push_back(dirtyRect);
+      copyBitmap(fonts_[font].chars[charCode], pages[charPages[i]], charRect.left, charRect.top);
+    }
+  }
 
-            if (newRect2.width && newRect2.height)
-              insertVector.push_back(newRect2);
+  return SDFF_OK;
+}
 
-            if (newRect3.width && newRect3.height)
-              insertVector.push_back(newRect3);
-          }
-          else if (vertexInCount == 4)
-          {
-            Rect newRect1 = freeRect;
-            Rect newRect2 = freeRect;
-            Rect newRect3 = freeRect;
-            Rect newRect4 = freeRect;
-
-            newRect1.width = charRect.left - newRect1.left;
-            newRect2.height = charRect.top - newRect2.top;
-            int dLeft = charRect.left + charRect.width - newRect3.left;
-            newRect3.left += dLeft;
-            newRect3.width -= dLeft;
-            int dTop = charRect.top + charRect.height - newRect4.top;
-            newRect4.top += dTop;
-            newRect4.height -= dTop;
-
-            if (newRect1.width)
-              insertVector.push_back(newRect1);
-
-            if (newRect2.height)
-              insertVector.push_back(newRect2);
-
-            if (newRect3.width)
-              insertVector.push_back(newRect3);
-
-            if (newRect4.height)
-              insertVector.push_back(newRect4);
-          }
-          else assert(0);
 
-          eraseVector.push_back(freeRectIt);
-        } // if (charRect.intersect(freeRect))
-      } // freeRects enumeration loop
+// the chars of all fonts, or the ones not in the pages of appendTexture yet, the largest ones first as they are packed
+void SDFF_Builder::listChars(bool newOnly, std::vector<CharKey> & charKeys, SDFF_Packer::RectVector & charRects)
+{
+  typedef std::multimap<int, CharKey> CharAreaMap;
+  CharAreaMap charAreas;
 
-      for (EraseVector::iterator eraseIt = eraseVector.begin(); eraseIt != eraseVector.end(); ++eraseIt)
-        freeRects.erase(*eraseIt);
+  for (FontMap::iterator fontIt = fonts_.begin(); fontIt != fonts_.end(); ++fontIt)
+  {
+    CharMap & chars = fontIt->second.chars;
 
-      for (InsertVector::iterator insertIt = insertVector.begin(); insertIt != insertVector.end(); ++insertIt)
-        freeRects.insert(*insertIt);
+    for (CharMap::iterator charIt = chars.begin(); charIt != chars.end(); ++charIt)
+    {
+      if (!newOnly || !fontIt->second.appendedChars.count(charIt->first))
+        charAreas.insert(std::make_pair(charIt->second.width() * charIt->second.height(), CharKey(fontIt->first, charIt->first)));
     }
   }
 
-  int width = maxRight + 1;
-  int height = maxBottom + 1;
+  charKeys.clear();
+  charRects.clear();
+  charKeys.reserve(charAreas.size());
+  charRects.reserve(charAreas.size());
 
-  if (powerOfTwo)
+  for (CharAreaMap::reverse_iterator charAreaIt = charAreas.rbegin(); charAreaIt != charAreas.rend(); ++charAreaIt)
   {
-    width = firstPowerOfTwoGreaterThen(width);
-    height = firstPowerOfTwoGreaterThen(height);
+    const SDFF_Bitmap & charBitmap = fonts_[charAreaIt->second.first].chars[charAreaIt->second.second];
+    SDFF_Packer::Rect charRect = { 0, 0, charBitmap.width(), charBitmap.height() };
+    charKeys.push_back(charAreaIt->second);
+    charRects.push_back(charRect);
   }
-  
-  bitmap.resize(width, height);
+}
+
+
+// Inserts the rects into the pages of the packers one by one, a page takes the rects left by the previous ones
+// and pages of the given size with packers of the given packing are added while some rects are left.
+// maxRight and maxBottom are the bounds of the rects over all pages
+void SDFF_Builder::insertIntoPages(PackerVector & packers, SDFF_Packing packing, int pageWidth, int pageHeight, SDFF_Packer::RectVector & charRects, std::vector<int> & charPages, int & maxRight, int & maxBottom)
+{
+  std::vector<int> charIds(charRects.size());
+  std::vector<int> nextCharIds;
+  SDFF_Packer::RectVector pageRects;
+  maxRight = 0;
+  maxBottom = 0;
+
+  for (size_t i = 0; i < charIds.size(); i++)
+    charIds[i] = (int)i;
 
-  for (CharRectMap::iterator charRectIt = charRects.begin(); charRectIt != charRects.end(); ++charRectIt)
+  for (int page = 0; !charIds.empty(); page++)
   {
-    Rect & charRect = charRectIt->second;
-    FontMap::iterator fontIt = fonts_.find(charRect.font);
+    bool opened = page == (int)packers.size();
 
-    if (fontIt != fonts_.end())
-    {
-      CharMap::iterator charIt = fontIt->second.chars.find(charRect.charCode);
+    if (opened)
+      packers.push_back(std::unique_ptr<SDFF_Packer>(SDFF_Packer::create(packing, &threadPool_, pageWidth, pageHeight)));
+
+    pageRects.clear();
 
-      if (charIt != fontIt->second.chars.end())
+    for (size_t i = 0; i < charIds.size(); i++)
+      pageRects.push_back(charRects[charIds[i]]);
+
+    int pageRight;
+    int pageBottom;
+    packers[page]->insert(pageRects, pageRight, pageBottom);
+    maxRight = glm::max(maxRight, pageRight);
+    maxBottom = glm::max(maxBottom, pageBottom);
+    nextCharIds.clear();
+
+    for (size_t i = 0; i < charIds.size(); i++)
+    {
+      if (pageRects[i].left < 0)
+        nextCharIds.push_back(charIds[i]);
+      else
       {
-        SDFF_Font * font = fontIt->first;
-        SDFF_Char charCode = charIt->first;
-        SDFF_Glyph & glyph = font->glyphs_[charCode];
-        glyph.left = float(charRect.left) / width;
-        glyph.right = float(charRect.right() + 1) / width;
-        glyph.top = float(charRect.top) / height;
-        glyph.bottom = float(charRect.bottom() + 1) / height;
-
-        SDFF_Bitmap & charBitmap = charIt->second;
-        copyBitmap(charBitmap, bitmap, charRect.left, charRect.top);
+        charRects[charIds[i]] = pageRects[i];
+        charPages[charIds[i]] = page;
       }
     }
-  }
 
-  return SDFF_OK;
+    // the first rect always fits an empty page
+    assert(!opened || nextCharIds.size() < charIds.size());
+    charIds.swap(nextCharIds);
+  }
 }
 
 
@@ -658,171 +893,636 @@ void SDFF_Builder::copyBitmap(const SDFF_Bitmap & srcBitmap, SDFF_Bitmap & destB
   assert(yPos >= 0);
   assert(xPos + srcBitmap.width() <= destBitmap.width());
   assert(yPos + srcBitmap.height() <= destBitmap.height());
+  assert(srcBitmap.channels() == destBitmap.channels());
 
+  int channels = destBitmap.channels();
   int srcIndex = 0;
-  int destIndex = yPos * destBitmap.width() + xPos;
+  int destIndex = (yPos * destBitmap.width() + xPos) * channels;
 
   for (int y = 0; y < srcBitmap.height(); y++)
   {
-    for (int x = 0; x < srcBitmap.width(); x++)
+    for (int x = 0; x < srcBitmap.width() * channels; x++)
     {
       destBitmap[destIndex] = destBitmap[destIndex] ? destBitmap[destIndex] : srcBitmap[srcIndex];
       srcIndex++;
       destIndex++;
     }
 
-    destIndex += destBitmap.width() - srcBitmap.width();
+    destIndex += (destBitmap.width() - srcBitmap.width()) * channels;
   }
 }
 
 
-float SDFF_Builder::createSdf(const FT_Bitmap & ftBitmap, int falloff, DistanceFieldVector & result) const
-{
-  float maxDist = createDf(ftBitmap, falloff, false, result);
-
-  DistanceFieldVector invResult;
-  float maxDistInv = createDf(ftBitmap, falloff, true, invResult);
-
-  for (int i = 0, cnt = result.size(); i < cnt; i++)
-  {
-    if (result[i] < 0.5f)
-      result[i] = 1 - invResult[i];
-  }
-
-  return glm::max(maxDist, maxDistInv - 1);
-}
-
 //  Based on "General algorithm for computing distance transforms in linear time"
 //  by A.MEIJSTER J.B.T.M.ROERDINK and W.H.HESSELINK
 //  University of Groningen
 //  http://www.rug.nl/research/portal/publications/a-general-algorithm-for-computing-distance-transforms-in-linear-time(15dd2ec9-d221-45da-b2b0-1164978717dc).html
 
-float SDFF_Builder::createDf(const FT_Bitmap & ftBitmap, int falloff, bool invert, DistanceFieldVector & result) const
+// Signed distance transform of the mono bitmap streamed into the downsampled field.
+// Rows go through both stages in blocks, so only a few rows of the full resolution field exist at a time.
+void SDFF_Builder::createSdf(const FT_Bitmap & ftBitmap, int falloff, int band, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler, EdtScratch & scratch, bool parallelRows, DistanceFieldVector & destSdf, FeatureVector * features)
 {
   assert(ftBitmap.width > 0);
   assert(ftBitmap.rows > 0);
   assert(falloff >= 0);
   int width = ftBitmap.width + 2 * falloff;
   int height = ftBitmap.rows + 2 * falloff;
-  unsigned char * pixels = ftBitmap.buffer;
-  int pitch = ftBitmap.pitch;
-  result.resize(width * height);
+  assert(width <= SHRT_MAX && height <= SHRT_MAX);
 
+  // nearest sites need to know if the column distance came from above or below,
+  // so the first stage keeps its down scan rows when sites are requested or edge correction measures to them
+  const bool edgeCorrection = options_.edgeCorrection;
+  const bool sites = features || edgeCorrection;
+
+  if (features)
+  {
+    FeaturePoint none = { -1, -1 };
+    features->assign(width * height, none);
+  }
+
+  // distances beyond the band are clamped to it, which makes columns and whole rows far from edges cheap
+  const int inf = width + height;
+  band = band > 0 ? glm::min(band, inf) : inf;
+  // squared distances stay unsigned 32-bit integers until the final square roots, the signed conversion there needs them under 2^31
+  assert(band < 46341);
+  const unsigned int bandSq = band * band;
+  // feature row of a column without ink or background below, its distance never wins over the first stage one
+  const int noneBelow = inf + 2 * height;
+
+  // squares of column distances and column indices, the second stage keeps squared distances as unsigned integers
+  // and takes square roots of a whole row at the end
+  int squareCount = glm::max(width, band);
+
+  if ((int)scratch.squares.size() < squareCount)
+  {
+    int i = (int)scratch.squares.size();
+    scratch.squares.resize(squareCount);
+
+    for (; i < squareCount; i++)
+      scratch.squares[i] = i * i;
+  }
+
+  const unsigned int * squares = scratch.squares.data();
+
+  // column parabolas take the squared column distance h_i = g_i * g_i, the envelope keeps it next to the column index
   struct
   {
-    int operator()(int x, int i, int g_i)
+    unsigned int operator()(int x, int i, unsigned int h_i) const
     {
-      return (x - i) * (x - i) + g_i * g_i;
+      return (unsigned int)((x - i) * (x - i)) + h_i;
     }
   } edt;
 
   struct
   {
-    int operator()(int i, int u, int g_i, int g_u)
+    const unsigned int * squares;
+
+    // the numerator may be negative, division truncates toward zero
+    int operator()(int i, int u, unsigned int h_i, unsigned int h_u) const
     {
-      return (u * u - i * i + g_u * g_u - g_i * g_i) / (2 * (u - i));
+      return (int)(squares[u] - squares[i] + h_u - h_i) / (2 * (u - i));
     }
-  } sep;
+  } sep = { squares };
 
-  // First stage
-  const int inf = width + height;
-  std::vector<int> g(width * height);
-  int invertValue = (int)invert;
+  // column searches in the padded bitmap, everything outside of the glyph bitmap is background.
+  // They run on the transposed bitmap, so a column is a sequence of bytes and bytes without the searched value are skipped whole
+  int columnPitch = transposeBitmap(ftBitmap, scratch.columns);
 
-  for (int x = 0; x < width; x++)	
+  struct
   {
-    int pix = invertValue;
-
-    if (!falloff)
+    const unsigned char * columns;
+    int columnPitch;
+    int falloff;
+    int bitmapWidth;
+    int bitmapRows;
+    int height;
+
+    bool inBitmap(int x, int y) const
     {
-      int ind = x / 8;
-      int shr = 7 - x % 8;
-      unsigned char byte = pixels[ind];
-      pix = ((byte >> shr) & 1) ^ invertValue;
+      return x >= falloff && x < falloff + bitmapWidth && y >= falloff && y < falloff + bitmapRows;
     }
 
-    if (pix)
-      g[x] = 0;
-    else
-      g[x] = inf;
+    // first bitmap row from row down where the bit of the bitmap column is value, bitmapRows if there is none
+    int nextBit(int bitmapX, int row, int value) const
+    {
+      const unsigned char * bytes = columns + bitmapX * columnPitch;
+      int flip = value ? 0 : 0xFF;
+      int i = row / 8;
+      int byte = (bytes[i] ^ flip) & (0xFF >> (row % 8));
 
-    // Scan 1
-    for (int y = 1; y < height; y++)	
+      while (!byte)
+      {
+        if (++i >= columnPitch)
+          return bitmapRows;
+
+        byte = bytes[i] ^ flip;
+      }
+
+      // clear bits past the last row read as background
+      return glm::min(i * 8 + 7 - glm::findMSB(byte), bitmapRows);
+    }
+
+    // last bitmap row from row up where the bit of the bitmap column is value, -1 if there is none
+    int prevBit(int bitmapX, int row, int value) const
     {
-      int pix = invertValue;
+      const unsigned char * bytes = columns + bitmapX * columnPitch;
+      int flip = value ? 0 : 0xFF;
+      int i = row / 8;
+      int byte = (bytes[i] ^ flip) & (0xFF << (7 - row % 8)) & 0xFF;
 
-      if (x >= falloff && x < width - falloff && y >= falloff && y < height - falloff)
+      while (!byte)
       {
-        int ind = (y - falloff) * pitch + (x - falloff) / 8;
-        int shr = 7 - (x - falloff) % 8;
-        unsigned char byte = pixels[ind];
-        pix = ((byte >> shr) & 1) ^ invertValue;
+        if (--i < 0)
+          return -1;
+
+        byte = bytes[i] ^ flip;
       }
 
-      if (pix)
-        g[x + y * width] = 0;
-      else
-        g[x + y * width] = 1 + g[x + (y - 1) * width];
+      return i * 8 + 7 - glm::findLSB(byte);
     }
 
-    // Scan 2
-    for (int y = height - 2; y >= 0; y--)	
+    // first row from y down where the pixel is value
+    int findDown(int x, int y, int value, int none) const
     {
-      if (g[x + (y + 1) * width] < g[x + y * width])
-        g[x + y * width] = 1 + g[x + (y + 1) * width];
+      if (value)
+      {
+        if (x < falloff || x >= falloff + bitmapWidth || y >= falloff + bitmapRows)
+          return none;
+
+        int row = nextBit(x - falloff, glm::max(y - falloff, 0), 1);
+
+        return row < bitmapRows ? falloff + row : none;
+      }
+
+      if (inBitmap(x, y))
+        y = falloff + nextBit(x - falloff, y - falloff, 0);
+
+      return y < height ? y : none;
     }
-  }
 
-  // Second stage
-  std::vector<int> s(width);
-  std::vector<int> t(width);
-  int q = 0;
-  int w;
-  float maxDistance = 0.0f;
+    // last row from y up to stop where the pixel is value
+    int findUp(int x, int y, int stop, int value, int none) const
+    {
+      if (value)
+      {
+        if (x < falloff || x >= falloff + bitmapWidth)
+          return none;
+
+        y = glm::min(y, falloff + bitmapRows - 1);
+
+        if (y < glm::max(stop, falloff))
+          return none;
+
+        y = falloff + prevBit(x - falloff, y - falloff, 1);
+
+        return y >= glm::max(stop, falloff) ? y : none;
+      }
+
+      if (inBitmap(x, y))
+        y = falloff + prevBit(x - falloff, y - falloff, 0);
 
-  for (int y = 0; y < height; y++)	
+      return y >= stop ? y : none;
+    }
+  } column = { scratch.columns.data(), columnPitch, falloff, (int)ftBitmap.width, (int)ftBitmap.rows, height };
+
+  // every thread owns a block of g rows with one extra row for the block boundary, the first stage state
+  // of the row above the block, next feature rows of the columns, envelopes and the distance row
+  const int rowBlockSize = 16;
+  int threadCount = parallelRows ? threadPool_.threadCount() : 1;
+  scratch.g.resize(2 * width * (rowBlockSize + 1) * threadCount);
+  scratch.gDown.resize(sites ? 2 * width * rowBlockSize * threadCount : 0);
+  scratch.sites.resize(sites ? width * threadCount : 0);
+  scratch.down.resize(2 * width * threadCount);
+  scratch.next.resize(2 * width * threadCount);
+  scratch.ink.assign(width * threadCount, 0);
+  scratch.runs.resize((width + 3) * threadCount);
+  scratch.envelopes.resize(3 * width * threadCount);
+  scratch.distancesSq.resize(2 * width * threadCount);
+  scratch.distances.resize(width * threadCount);
+  int destWidth = horzResampler.destSize();
+  int destHeight = vertResampler.destSize();
+  scratch.resampled.resize(destWidth * threadCount);
+
+  SDFF_ThreadPool::RangeFunc rowStage = [&](int firstDestRow, int lastDestRow, int threadIndex)
   {
-    q = 0;
-    s[0] = 0;
-    t[0] = 0;
+    int * g = &scratch.g[2 * width * (rowBlockSize + 1) * threadIndex];
+    int * gDown = sites ? &scratch.gDown[2 * width * rowBlockSize * threadIndex] : NULL;
+    FeaturePoint * siteRow = sites ? &scratch.sites[width * threadIndex] : NULL;
+    int * down = &scratch.down[2 * width * threadIndex];
+    int * next = &scratch.next[2 * width * threadIndex];
+    unsigned char * ink = &scratch.ink[width * threadIndex];
+    int * runs = &scratch.runs[(width + 3) * threadIndex];
+    int * s = &scratch.envelopes[3 * width * threadIndex];
+    int * t = s + width;
+    unsigned int * h = (unsigned int *)(t + width);
+    unsigned int * distancesSq = &scratch.distancesSq[2 * width * threadIndex];
+    float * distances = &scratch.distances[width * threadIndex];
+    float * resampled = &scratch.resampled[destWidth * threadIndex];
+    int q = 0;
+    int w;
+
+    // source rows gathered by the dest rows
+    int firstRow = height;
+    int lastRow = 0;
+
+    for (int destY = firstDestRow; destY < lastDestRow; destY++)
+    {
+      firstRow = glm::min(firstRow, vertResampler.srcBegin(destY));
+      lastRow = glm::max(lastRow, vertResampler.srcEnd(destY));
+    }
 
-      // Scan 3
-    for (int x = 1; x < width; x++)	
+    // first stage state of the row above, ink farther than the band does not matter
+    int upStop = glm::max(firstRow - band, 0);
+
+    for (int x = 0; x < width; x++)
     {
-      while (q >= 0 && edt(t[q], s[q], g[s[q] + y * width]) > edt(t[q], x, g[x + y * width]))
-        q--;
+      if (firstRow)
+      {
+        int lastInk = column.findUp(x, firstRow - 1, upStop, 1, -1);
+        int lastBackground = column.findUp(x, firstRow - 1, upStop, 0, -1);
+        down[x] = lastInk >= 0 ? firstRow - 1 - lastInk : inf + firstRow - 1;
+        down[x + width] = lastBackground >= 0 ? firstRow - 1 - lastBackground : inf + firstRow - 1;
+      }
+      else
+      {
+        down[x] = inf - 1;
+        down[x + width] = inf - 1;
+      }
+
+      next[x] = -1;
+      next[x + width] = -1;
+    }
+
+    for (int blockRow = firstRow; blockRow < lastRow; blockRow += rowBlockSize)
+    {
+      int blockEnd = glm::min(blockRow + rowBlockSize, lastRow);
+      int scanEnd = glm::min(blockEnd + 1, height);
+
+      // First stage
+      // runs row by row so adjacent columns are processed together by SIMD kernels;
+      // each g row holds outer distances (to the nearest ink pixel) followed by inner ones (to the nearest background pixel)
 
-      if (q < 0)	
+      // Scan 1, over the block and its boundary row
+      for (int y = blockRow; y < scanEnd; y++)
       {
-        q = 0;
-        s[0] = x;
+        int bitmapY = y - falloff;
+        unsigned char * inkRow = ink + falloff;
+
+        if (bitmapY >= 0 && bitmapY < (int)ftBitmap.rows)
+          SDFF_Simd::unpackBits(simdLevel_, ftBitmap.buffer + bitmapY * ftBitmap.pitch, inkRow, ftBitmap.width);
+        else
+          memset(inkRow, 0, ftBitmap.width);
+
+        const int * prevRow = y > blockRow ? &g[2 * (y - 1 - blockRow) * width] : down;
+        SDFF_Simd::edtScanDown(simdLevel_, ink, prevRow, &g[2 * (y - blockRow) * width], width);
+      }
+
+      memcpy(down, &g[2 * (blockEnd - 1 - blockRow) * width], 2 * width * sizeof(int));
+
+      if (sites)
+        memcpy(gDown, g, 2 * width * (blockEnd - blockRow) * sizeof(int));
+
+      // boundary row below the block takes the distance to the next feature down the column,
+      // the pointers only move forward, so the columns are searched once per thread range
+      if (blockEnd < height)
+      {
+        int * boundary = &g[2 * (blockEnd - blockRow) * width];
+
+        for (int x = 0; x < width; x++)
+        {
+          if (next[x] < blockEnd)
+            next[x] = column.findDown(x, blockEnd, 1, noneBelow);
+
+          if (next[x + width] < blockEnd)
+            next[x + width] = column.findDown(x, blockEnd, 0, noneBelow);
+
+          boundary[x] = glm::min(boundary[x], next[x] - blockEnd);
+          boundary[x + width] = glm::min(boundary[x + width], next[x + width] - blockEnd);
+        }
       }
-      else	
+
+      // Scan 2
+      for (int y = scanEnd - 2; y >= blockRow; y--)
+        SDFF_Simd::edtScanUp(simdLevel_, &g[2 * (y + 1 - blockRow) * width], &g[2 * (y - blockRow) * width], 2 * width);
+
+      // Second stage
+      for (int y = blockRow; y < blockEnd; y++)
       {
-        w = 1 + sep(s[q], x, g[s[q] + y * width], g[x + y * width]);
+        const int * gRow = &g[2 * (y - blockRow) * width];
+        const int * gDownRow = sites ? &gDown[2 * (y - blockRow) * width] : NULL;
+
+        if (sites)
+        {
+          FeaturePoint none = { -1, -1 };
+          std::fill(siteRow, siteRow + width, none);
+        }
+
+        int runCount = rowRuns(ftBitmap, y - falloff, falloff, width, runs);
+
+        for (int inner = 0; inner < 2; inner++)
+        {
+          const int * gSide = gRow + inner * width;
+          q = -1;
+          // ink runs hold zero outer distances, background runs zero inner ones
+          int zeroRun = 1 - inner;
+
+          // Scan 3
+          // columns which are the band away from the edge can not bring any distance of the row under the band
+          for (int x = 0; x < width; x++)
+          {
+            // inside a run of zero distances only its ends can be the nearest column of a pixel on this side,
+            // pixels in the run itself take the other side
+            if (zeroRun < runCount && x == runs[zeroRun] + 1)
+            {
+              x = glm::max(x, runs[zeroRun + 1] - 1);
+              zeroRun += 2;
+            }
+
+            if (gSide[x] >= band)
+              continue;
+
+            unsigned int h_x = squares[gSide[x]];
+
+            if (q < 0)
+            {
+              q = 0;
+              s[0] = x;
+              t[0] = 0;
+              h[0] = h_x;
+              continue;
+            }
+
+            while (q >= 0 && edt(t[q], s[q], h[q]) > edt(t[q], x, h_x))
+              q--;
+
+            if (q < 0)
+            {
+              q = 0;
+              s[0] = x;
+              h[0] = h_x;
+            }
+            else
+            {
+              w = 1 + sep(s[q], x, h[q], h_x);
+
+              if (w < width)
+              {
+                q++;
+                s[q] = x;
+                t[q] = w;
+                h[q] = h_x;
+              }
+            }
+          }
 
-        if (w < width)	
+          // Scan 4
+          // fills every envelope segment with squared distances to its column, the ink decides which side a pixel takes later
+          unsigned int * sideSq = distancesSq + inner * width;
+          int end = width;
+
+          if (q < 0)
+            std::fill(sideSq, sideSq + width, bandSq);
+
+          for (; q >= 0; q--)
+          {
+            int siteX = s[q];
+
+            for (int x = t[q]; x < end; x++)
+              sideSq[x] = edt(x, siteX, h[q]);
+
+            if (sites)
+            {
+              // the nearest site is in the envelope column, above the pixel unless the up scan lowered its distance
+              int siteDy = gSide[siteX];
+              FeaturePoint site = { (short)siteX, (short)(gDownRow[siteX + inner * width] == siteDy ? y - siteDy : y + siteDy) };
+
+              // ink pixels (zero outer distance) take their sites from the inner side, background ones from the outer side
+              for (int x = t[q]; x < end; x++)
+              {
+                if ((gRow[x] == 0) == (inner != 0) && sideSq[x] < bandSq)
+                  siteRow[x] = site;
+              }
+            }
+
+            end = t[q];
+          }
+        }
+
+        SDFF_Simd::edtDistances(simdLevel_, gRow, distancesSq, bandSq, distances, width);
+
+        // distance to the nearest point of the site pixel square puts the edge halfway between pixels
+        if (edgeCorrection)
         {
-          q++;
-          s[q] = x;
-          t[q] = w;
+          for (int x = 0; x < width; x++)
+          {
+            if (siteRow[x].x >= 0)
+            {
+              glm::vec2 offset = glm::max(glm::vec2((float)glm::abs(x - siteRow[x].x), (float)glm::abs(y - siteRow[x].y)) - 0.5f, 0.0f);
+              distances[x] = gRow[x] ? glm::length(offset) : -glm::length(offset);
+            }
+          }
         }
+
+        // a source row shared by two ranges belongs to the one holding its first dest row
+        int owner = vertResampler.destBegin(y);
+
+        if (features && owner >= firstDestRow && owner < lastDestRow)
+          memcpy(&(*features)[y * width], siteRow, width * sizeof(FeaturePoint));
+
+        downsampleRow(distances, y, horzResampler, vertResampler, firstDestRow, lastDestRow, resampled, destSdf.data());
       }
     }
+  };
 
-    // Scan 4
-    for (int x = width - 1; x >= 0; x--)	
+  // dest rows are split between threads, source rows on the boundaries are transformed by both neighbors,
+  // so blocks are kept larger than the dest rows one filter window spans
+  if (parallelRows)
+  {
+    int windowRows = vertResampler.span() * destHeight / height + 1;
+    threadPool_.parallelFor(destHeight, glm::max(destHeight / (4 * threadCount), 2 * windowRows), rowStage);
+  }
+  else
+    rowStage(0, destHeight, 0);
+}
+
+
+// Outward unit normals of the nearest edge from the site map of the transform, downsampled on the texel grid of the distances.
+// A pixel outside of the glyph points away from its nearest ink pixel, one inside towards its nearest background pixel;
+// pixels without a site add nothing. normals holds the sums of the x components (right) followed by the y ones (down).
+void SDFF_Builder::createNormals(const FT_Bitmap & ftBitmap, int falloff, const FeatureVector & features, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler, EdtScratch & scratch, bool parallelRows, DistanceFieldVector & normals)
+{
+  int width = ftBitmap.width + 2 * falloff;
+  int height = ftBitmap.rows + 2 * falloff;
+  int destWidth = horzResampler.destSize();
+  int destHeight = vertResampler.destSize();
+  assert((int)features.size() == width * height);
+  int threadCount = parallelRows ? threadPool_.threadCount() : 1;
+  scratch.normalRows.resize(2 * width * threadCount);
+  scratch.resampled.resize(destWidth * threadCount);
+  normals.assign(2 * destWidth * destHeight, 0.0f);
+
+  SDFF_ThreadPool::RangeFunc rowStage = [&](int firstDestRow, int lastDestRow, int threadIndex)
+  {
+    float * normalX = &scratch.normalRows[2 * width * threadIndex];
+    float * normalY = normalX + width;
+    float * resampled = &scratch.resampled[destWidth * threadIndex];
+    int firstRow = height;
+    int lastRow = 0;
+
+    for (int destY = firstDestRow; destY < lastDestRow; destY++)
+    {
+      firstRow = glm::min(firstRow, vertResampler.srcBegin(destY));
+      lastRow = glm::max(lastRow, vertResampler.srcEnd(destY));
+    }
+
+    for (int y = firstRow; y < lastRow; y++)
     {
-      float distance = std::sqrtf((float)edt(x, s[q], g[s[q] + y * width]));
-      result[x + y * width] = distance;
+      const FeaturePoint * siteRow = &features[y * width];
+      int bitmapY = y - falloff;
+      const unsigned char * bits = bitmapY >= 0 && bitmapY < (int)ftBitmap.rows ? ftBitmap.buffer + bitmapY * ftBitmap.pitch : NULL;
+
+      for (int x = 0; x < width; x++)
+      {
+        normalX[x] = 0.0f;
+        normalY[x] = 0.0f;
+
+        if (siteRow[x].x < 0)
+          continue;
+
+        int bitmapX = x - falloff;
+        bool ink = bits && bitmapX >= 0 && bitmapX < (int)ftBitmap.width && (bits[bitmapX >> 3] & (0x80 >> (bitmapX & 7)));
+        // the site is a pixel of the other kind, never the pixel itself
+        glm::vec2 normal = glm::normalize(glm::vec2((float)(x - siteRow[x].x), (float)(y - siteRow[x].y)));
+        normal = ink ? -normal : normal;
+        normalX[x] = normal.x;
+        normalY[x] = normal.y;
+      }
+
+      downsampleRow(normalX, y, horzResampler, vertResampler, firstDestRow, lastDestRow, resampled, normals.data());
+      downsampleRow(normalY, y, horzResampler, vertResampler, firstDestRow, lastDestRow, resampled, normals.data() + destWidth * destHeight);
+    }
+  };
+
+  if (parallelRows)
+    threadPool_.parallelFor(destHeight, glm::max(destHeight / (4 * threadCount), 1), rowStage);
+  else
+    rowStage(0, destHeight, 0);
+}
+
+
+// Adds one source row into the dest rows it contributes to, the row is gathered horizontally first;
+// the box filter adds the pixels one by one to keep its rounding. Only dest rows in [firstDestRow, lastDestRow) are written.
+void SDFF_Builder::downsampleRow(const float * srcRow, int y, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler, int firstDestRow, int lastDestRow, float * resampledRow, float * destSdf) const
+{
+  int destWidth = horzResampler.destSize();
+  int destBegin = glm::max(vertResampler.destBegin(y), firstDestRow);
+  int destEnd = glm::min(vertResampler.destEnd(y), lastDestRow);
+
+  if (destBegin >= destEnd)
+    return;
+
+  if (horzResampler.filter() == SDFF_FILTER_BOX)
+  {
+    for (int destY = destBegin; destY < destEnd; destY++)
+      horzResampler.accumulate(srcRow, vertResampler.weight(destY, y), destSdf + destY * destWidth);
+
+    return;
+  }
+
+  horzResampler.resample(simdLevel_, srcRow, resampledRow);
+
+  for (int destY = destBegin; destY < destEnd; destY++)
+    SDFF_Simd::accumulateRow(simdLevel_, vertResampler.weight(destY, y), resampledRow, destSdf + destY * destWidth, destWidth);
+}
+
+
+// Splits a padded row into runs of background and ink, run k starts at runs[k] and ends at runs[k + 1],
+// even runs are background. Returns the run count, runs[count] is the row width.
+// Bits are read a byte at a time, uniform bytes with no transition are skipped.
+int SDFF_Builder::rowRuns(const FT_Bitmap & ftBitmap, int bitmapY, int falloff, int width, int * runs)
+{
+  int count = 0;
+  runs[count++] = 0;
+
+  if (bitmapY >= 0 && bitmapY < (int)ftBitmap.rows)
+  {
+    const unsigned char * bits = ftBitmap.buffer + bitmapY * ftBitmap.pitch;
+    int byteCount = ((int)ftBitmap.width + 7) / 8;
+    // ink of the previous pixel
+    int last = 0;
+
+    for (int i = 0; i < byteCount; i++)
+    {
+      int byte = bits[i];
+
+      // padding bits after the last pixel are not guaranteed to be clear
+      if (i == byteCount - 1 && ftBitmap.width % 8)
+        byte &= 0xFF << (8 - ftBitmap.width % 8);
+
+      if (byte == (last ? 0xFF : 0))
+        continue;
+
+      // bit j is set where pixel j differs from the one before it
+      int changes = byte ^ ((byte >> 1) | (last << 7));
+
+      while (changes)
+      {
+        int bit = glm::findMSB(changes);
+        runs[count++] = falloff + i * 8 + 7 - bit;
+        changes ^= 1 << bit;
+      }
+
+      last = byte & 1;
+    }
+
+    if (last)
+      runs[count++] = falloff + ftBitmap.width;
+  }
+
+  runs[count] = width;
+
+  return count;
+}
+
+
+// Transposes a mono bitmap into columns in 8x8 bit blocks, byte i of column x holds rows [8 * i, 8 * i + 8)
+// most significant bit first, bits past the last row are clear. Returns the byte count of a column.
+int SDFF_Builder::transposeBitmap(const FT_Bitmap & ftBitmap, std::vector<unsigned char> & columns)
+{
+  int rows = ftBitmap.rows;
+  int columnPitch = (rows + 7) / 8;
+  int blockColumns = (ftBitmap.width + 7) / 8;
+  columns.resize(8 * blockColumns * columnPitch);
+
+  for (int rowBlock = 0; rowBlock < columnPitch; rowBlock++)
+  {
+    const unsigned char * bits = ftBitmap.buffer + 8 * rowBlock * ftBitmap.pitch;
+    int blockRows = glm::min(rows - 8 * rowBlock, 8);
+
+    for (int blockColumn = 0; blockColumn < blockColumns; blockColumn++)
+    {
+      // row k of the block goes into byte 7 - k of the word, three delta swaps transpose it in place
+      uint64_t block = 0;
+
+      for (int k = 0; k < blockRows; k++)
+        block |= (uint64_t)bits[k * ftBitmap.pitch + blockColumn] << (56 - 8 * k);
+
+      if (block)
+      {
+        uint64_t t = (block ^ (block >> 7)) & 0x00AA00AA00AA00AAULL;
+        block ^= t ^ (t << 7);
+        t = (block ^ (block >> 14)) & 0x0000CCCC0000CCCCULL;
+        block ^= t ^ (t << 14);
+        t = (block ^ (block >> 28)) & 0x00000000F0F0F0F0ULL;
+        block ^= t ^ (t << 28);
+      }
 
-      if (distance > maxDistance)
-        maxDistance = distance;
+      unsigned char * dest = &columns[8 * blockColumn * columnPitch + rowBlock];
 
-      if (x == t[q])
-        q--;
+      for (int k = 0; k < 8; k++)
+        dest[k * columnPitch] = (unsigned char)(block >> (56 - 8 * k));
     }
   }
 
-  return maxDistance;
+  return columnPitch;
 }
@@ -2,6 +2,24 @@
 #include "sdff_error.h"
 #include "sdff_bitmap.h"
 #include "sdff_font.h"
+#include "sdff_options.h"
+#include "sdff_thread_pool.h"
+#include "sdff_edtaa.h"
+#include "sdff_outline.h"
+#include "sdff_packer.h"
+#include "sdff_resampler.h"
+#include "sdff_sampled.h"
+#include "sdff_transform.h"
+
+// Area of an atlas page changed by appendTexture
+struct SDFF_DirtyRect
+{
+  int page;
+  int left;
+  int top;
+  int width;
+  int height;
+};
 
 class SDFF_Builder
 {
@@ -9,12 +27,24 @@ public:
   SDFF_Builder();
   ~SDFF_Builder();
 
-  SDFF_Error init(int sourceFontSize, int sdfFontSize, float falloff);
+  SDFF_Error init(int sourceFontSize, int sdfFontSize, float falloff, const SDFF_Options & options = SDFF_Options());
   SDFF_Error addFont(const char * fileName, int faceIndex, SDFF_Font * out_font);
   SDFF_Error addChar(SDFF_Font & font, SDFF_Char charCode);
   SDFF_Error addChars(SDFF_Font & font, SDFF_Char firstCharCode, SDFF_Char lastCharCode);
   SDFF_Error addChars(SDFF_Font & font, const char * charString);
-  SDFF_Error composeTexture(SDFF_Bitmap & bitmap, bool powerOfTwo);
+  SDFF_Error composeTexture(SDFF_Bitmap & bitmap, bool powerOfTwo, SDFF_Packing packing = SDFF_PACKING_FREE_RECTS);
+  // Packs the glyphs into pages of at most maxPageWidth x maxPageHeight, SDFF_Glyph::page is the page of a glyph.
+  // All pages have the same size, so they can be the layers of a texture array; glyphs fitting one page get one page
+  // packed the same way as the single bitmap
+  SDFF_Error composeTexture(std::vector<SDFF_Bitmap> & pages, bool powerOfTwo, int maxPageWidth, int maxPageHeight, SDFF_Packing packing = SDFF_PACKING_FREE_RECTS);
+  // Places the glyphs added since the previous call into the free space of the pages, the glyphs placed before
+  // keep their pages and UVs; a new page is opened when they do not fit. dirtyRects get the areas of the new glyphs,
+  // the only parts of the pages to upload again. The first call opens the pages of the given size, the next ones
+  // take the same pages and size back; composeTexture and init start it over. The free rects packer keeps the free
+  // space between the calls
+  SDFF_Error appendTexture(std::vector<SDFF_Bitmap> & pages, int pageWidth, int pageHeight, std::vector<SDFF_DirtyRect> & dirtyRects);
+  // per thread load balance of the parallel glyph building since init, glyphs built one by one are not counted
+  const std::vector<SDFF_WorkerStats> & workerStats() const { return threadPool_.stats(); }
 
 private:
 
@@ -22,12 +52,76 @@ private:
   
   struct FontData
   {
-    FT_Face ftFace;
+    std::string fileName;
+    int faceIndex;
+    // one face per worker, faces are opened on demand
+    std::vector<FT_Face> ftFaces;
     CharMap chars;
+    // chars already in the pages of appendTexture
+    std::unordered_set<SDFF_Char> appendedChars;
   };
 
   typedef std::map<SDFF_Font *, FontData> FontMap;
+  typedef std::pair<SDFF_Font *, SDFF_Char> CharKey;
+  typedef std::vector<std::unique_ptr<SDFF_Packer> > PackerVector;
   typedef std::vector<float> DistanceFieldVector;
+  // weight tables by source and dest size
+  typedef std::map<std::pair<int, int>, SDFF_Resampler> ResamplerMap;
+
+  // nearest site of a pixel in the padded source bitmap, (-1, -1) beyond the band
+  struct FeaturePoint
+  {
+    short x;
+    short y;
+  };
+
+  typedef std::vector<FeaturePoint> FeatureVector;
+
+  // per thread parts of the mono transform, all of them linear in the source width
+  struct EdtScratch
+  {
+    std::vector<int> g;
+    std::vector<int> gDown;
+    FeatureVector sites;
+    std::vector<int> down;
+    std::vector<int> next;
+    std::vector<unsigned char> ink;
+    std::vector<int> runs;
+    std::vector<unsigned char> columns;
+    std::vector<int> envelopes;
+    std::vector<unsigned int> squares;
+    std::vector<unsigned int> distancesSq;
+    std::vector<float> distances;
+    std::vector<float> resampled;
+    std::vector<float> normalRows;
+  };
+
+  // per thread resources for building glyphs concurrently
+  struct Worker
+  {
+    FT_Library ftLibrary;
+    EdtScratch edt;
+    SDFF_EdtAA edtAA;
+    SDFF_Outline outline;
+    SDFF_SampledSdf sampled;
+    std::unique_ptr<SDFF_DistanceTransform> transform;
+    ResamplerMap resamplers;
+    DistanceFieldVector srcSdf;
+    DistanceFieldVector resampledRow;
+    DistanceFieldVector destSdf;
+    // full resolution site map and downsampled normals of the normals option
+    FeatureVector features;
+    DistanceFieldVector normals;
+  };
+
+  struct CharResult
+  {
+    SDFF_Error error;
+    SDFF_Bitmap bitmap;
+    SDFF_Glyph glyph;
+  };
+
+  typedef std::vector<Worker> WorkerVector;
 
   FT_Library ftLibrary_;
   FontMap fonts_;
@@ -37,9 +131,34 @@ private:
   bool initialized_;
   int maxSrcDfSize_;
   int maxDstDfSize_;
+  SDFF_SimdLevel simdLevel_;
+  SDFF_Options options_;
+  SDFF_ThreadPool threadPool_;
+  WorkerVector workers_;
+  // one packer per page of appendTexture, keeping its free space between the calls
+  PackerVector appendPackers_;
+  int appendPageWidth_;
+  int appendPageHeight_;
 
+  bool outlineMode() const { return options_.mode == SDFF_MODE_OUTLINE || options_.mode == SDFF_MODE_MSDF || options_.mode == SDFF_MODE_MTSDF; }
+  int bitmapChannels() const { return options_.mode == SDFF_MODE_MSDF ? 3 : options_.mode == SDFF_MODE_MTSDF ? 4 : options_.normals ? 3 : 1; }
+  SDFF_Error addCharList(SDFF_Font & font, const SDFF_Char * charCodes, int charCount);
+  float estimateCharCost(FT_Face ftFace, SDFF_Char charCode) const;
+  int glyphSourceSize(FT_Face ftFace, SDFF_Char charCode) const;
+  SDFF_Error buildChar(FontData & fontData, int workerIndex, SDFF_Char charCode, bool parallelRows, CharResult & result);
+  void commitChar(SDFF_Font & font, FontData & fontData, SDFF_Char charCode, CharResult & result);
+  SDFF_Error openFace(FontData & fontData, int workerIndex);
+  void releaseWorkers();
   unsigned int firstPowerOfTwoGreaterThen(unsigned int value);
-  float createSdf(const FT_Bitmap & ftBitmap, int falloff, DistanceFieldVector & result) const;
-  float createDf(const FT_Bitmap & ftBitmap, int falloff, bool invert, DistanceFieldVector & result) const;
+  void listChars(bool newOnly, std::vector<CharKey> & charKeys, SDFF_Packer::RectVector & charRects);
+  void insertIntoPages(PackerVector & packers, SDFF_Packing packing, int pageWidth, int pageHeight, SDFF_Packer::RectVector & charRects, std::vector<int> & charPages, int & maxRight, int & maxBottom);
+  const SDFF_Resampler & resampler(Worker & worker, int srcSize, int destSize);
+  int narrowBand(int srcFalloff, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler) const;
+  SDFF_Error createOutlineBitmap(FT_GlyphSlot ftGlyph, Worker & worker, SDFF_Bitmap & charBitmap);
+  void createSdf(const FT_Bitmap & ftBitmap, int falloff, int band, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler, EdtScratch & scratch, bool parallelRows, DistanceFieldVector & destSdf, FeatureVector * features = NULL);
+  void createNormals(const FT_Bitmap & ftBitmap, int falloff, const FeatureVector & features, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler, EdtScratch & scratch, bool parallelRows, DistanceFieldVector & normals);
+  static int transposeBitmap(const FT_Bitmap & ftBitmap, std::vector<unsigned char> & columns);
+  static int rowRuns(const FT_Bitmap & ftBitmap, int bitmapY, int falloff, int width, int * runs);
+  void downsampleRow(const float * srcRow, int y, const SDFF_Resampler & horzResampler, const SDFF_Resampler & vertResampler, int firstDestRow, int lastDestRow, float * resampledRow, float * destSdf) const;
   void copyBitmap(const SDFF_Bitmap & srcBitmap, SDFF_Bitmap & destBitmap, int posX, int posY) const;
 };
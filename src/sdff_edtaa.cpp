@@ -0,0 +1,305 @@
+#include "static_headers.h"
+
+#include "sdff_edtaa.h"
+
+//  Based on "Anti-aliased Euclidean distance transform"
+//  by Stefan Gustavson and Robin Strand
+//  Pattern Recognition Letters 32 (2011)
+
+float SDFF_EdtAA::createSdf(const unsigned char * coverage, int coverageWidth, int coverageHeight, int pitch, int falloff, int band, DistanceFieldVector & result)
+{
+  return createSdf(coverage, coverageWidth, coverageHeight, pitch, falloff, band, 0, coverageHeight + 2 * falloff, result);
+}
+
+
+float SDFF_EdtAA::createSdf(const unsigned char * coverage, int coverageWidth, int coverageHeight, int pitch, int falloff, int band, int firstRow, int rowCount, DistanceFieldVector & result)
+{
+  assert(coverageWidth > 0);
+  assert(coverageHeight > 0);
+  assert(falloff >= 0);
+  assert(band >= 0);
+  assert(firstRow >= 0 && rowCount > 0 && firstRow + rowCount <= coverageHeight + 2 * falloff);
+  int width = coverageWidth + 2 * falloff;
+  int height = rowCount;
+  int paddedWidth = width + 2;
+  assert(paddedWidth < SHRT_MAX && height + 2 < SHRT_MAX);
+
+  image_.assign(paddedWidth * (height + 2), 0.0f);
+
+  for (int y = glm::max(firstRow - falloff, 0); y < glm::min(firstRow + rowCount - falloff, coverageHeight); y++)
+  {
+    const unsigned char * coverageRow = coverage + y * pitch;
+    float * imageRow = image_.data() + (y + falloff - firstRow + 1) * paddedWidth + falloff + 1;
+
+    for (int x = 0; x < coverageWidth; x++)
+      imageRow[x] = coverageRow[x] / 255.0f;
+  }
+
+  computeGradient(width, height);
+  transform(width, height, band);
+  result.resize(width * height);
+  float maxDistance = 0.0f;
+
+  for (int y = 0; y < height; y++)
+  for (int x = 0; x < width; x++)
+  {
+    int i = x + 1 + (y + 1) * paddedWidth;
+    float d = sides_[i] == SIDE_INNER ? -dist_[i] : dist_[i];
+
+    // pixels past the band keep the distances of the pixels they were reached from, or none at all
+    if (band)
+      d = glm::clamp(d, -(float)band, (float)band);
+
+    result[x + y * width] = d;
+    maxDistance = glm::max(maxDistance, glm::abs(d));
+  }
+
+  return maxDistance;
+}
+
+
+void SDFF_EdtAA::computeGradient(int width, int height)
+{
+  const float sqrt2 = 1.4142136f;
+  int w = width + 2;
+  gradX_.assign(w * (height + 2), 0.0f);
+  gradY_.assign(w * (height + 2), 0.0f);
+
+  // the outermost transformed pixels have no gradient, as if there were no padding
+  for (int y = 2; y < height; y++)
+  for (int x = 2; x < width; x++)
+  {
+    int i = x + y * w;
+    const float * img = image_.data();
+
+    // only edge pixels need the gradient
+    if (img[i] > 0.0f && img[i] < 1.0f)
+    {
+      float gx = -img[i - w - 1] - sqrt2 * img[i - 1] - img[i + w - 1] + img[i - w + 1] + sqrt2 * img[i + 1] + img[i + w + 1];
+      float gy = -img[i - w - 1] - sqrt2 * img[i - w] - img[i - w + 1] + img[i + w - 1] + sqrt2 * img[i + w] + img[i + w + 1];
+      float length = std::sqrt(gx * gx + gy * gy);
+
+      if (length > 0.0f)
+      {
+        gradX_[i] = gx / length;
+        gradY_[i] = gy / length;
+      }
+    }
+  }
+}
+
+
+// Distance from the pixel center to the edge inside of a pixel with coverage a,
+// the edge is approximated by a line orthogonal to the gradient (gx, gy)
+float SDFF_EdtAA::edgeDistance(float gx, float gy, float a)
+{
+  if (gx == 0.0f || gy == 0.0f)
+    return 0.5f - a;
+
+  float length = std::sqrt(gx * gx + gy * gy);
+  return unitEdgeDistance(glm::abs(gx / length), glm::abs(gy / length), a);
+}
+
+
+// The same for the absolute components of a unit gradient, both nonzero
+float SDFF_EdtAA::unitEdgeDistance(float gx, float gy, float a)
+{
+  return unitEdgeDistance(unitDirection(gx, gy), a);
+}
+
+
+float SDFF_EdtAA::unitEdgeDistance(const Direction & direction, float a)
+{
+  float gx = direction.gx;
+  float gy = direction.gy;
+
+  if (a < direction.a1)
+    return 0.5f * (gx + gy) - std::sqrt(2.0f * gx * gy * a);
+  else if (a < 1.0f - direction.a1)
+    return (0.5f - a) * gx;
+  else
+    return -0.5f * (gx + gy) + std::sqrt(2.0f * gx * gy * (1.0f - a));
+}
+
+
+SDFF_EdtAA::Direction SDFF_EdtAA::unitDirection(float gx, float gy)
+{
+  if (gx < gy)
+    std::swap(gx, gy);
+
+  Direction direction = { gx, gy, 0.5f * gy / gx };
+  return direction;
+}
+
+
+// Distance from a pixel to the edge inside of the pixel closest to its neighbor c,
+// (xc, yc) - offset from the closest pixel to c, (xi, yi) - offset from the closest pixel to our pixel.
+// The inner side measures the distance to the edge of the inverted image
+float SDFF_EdtAA::distance(int width, int c, int xc, int yc, int xi, int yi, bool inner) const
+{
+  int closest = c - xc - yc * width;
+  float a = glm::clamp(inner ? 1.0f - image_[closest] : image_[closest], 0.0f, 1.0f);
+
+  if (a == 0.0f)
+    return FLT_MAX;
+
+  int ax = glm::abs(xi);
+  int ay = glm::abs(yi);
+
+  if (ax == 0 && ay == 0)
+    return edgeDistance(gradX_[closest], gradY_[closest], a);
+  else if (ax == 0 || ay == 0)
+    return float(ax + ay) + (0.5f - a);
+  else if (ax < offsetRadius && ay < offsetRadius)
+  {
+    const Offset & offset = offsets_[ax + ay * offsetRadius];
+    return offset.length + unitEdgeDistance(offset.direction, a);
+  }
+
+  float di = std::sqrt(float(xi * xi + yi * yi));
+  return di + unitEdgeDistance(ax / di, ay / di, a);
+}
+
+
+// Both sides in the two raster sweeps of the paper, without repeating them until nothing changes. The outer side
+// is transformed on the image and the inner one on the inverted image with the same gradient, edge distance depends
+// on its direction only. A pixel has a positive distance on one side at most and zero or less on the other one,
+// where it stays its own closest edge pixel; so one distance and offset per pixel hold both transforms, its side
+// telling which. With a band, neighbors farther than it plus a couple of pixels pass nothing on; a pixel within
+// the band takes its edge through pixels at most about that far, so only distances the caller clamps change
+void SDFF_EdtAA::transform(int width, int height, int band)
+{
+  const float epsilon = 1e-3f;
+  const float unreached = 1000000.0f;
+  int paddedWidth = width + 2;
+  int size = paddedWidth * (height + 2);
+  distX_.assign(size, 0);
+  distY_.assign(size, 0);
+  dist_.assign(size, unreached);
+  sides_.assign(size, SIDE_NONE);
+
+  // the square roots and divisions of the nearer offsets are done once
+  if (offsets_.empty())
+  {
+    offsets_.resize(offsetRadius * offsetRadius);
+
+    for (int y = 1; y < offsetRadius; y++)
+    for (int x = 1; x < offsetRadius; x++)
+    {
+      Offset & offset = offsets_[x + y * offsetRadius];
+      offset.length = std::sqrt(float(x * x + y * y));
+      offset.direction = unitDirection(x / offset.length, y / offset.length);
+    }
+  }
+
+  for (int y = 1; y <= height; y++)
+  for (int x = 1; x <= width; x++)
+  {
+    int i = x + y * paddedWidth;
+    float a = image_[i];
+
+    // pixels over half covered take their distances from the inverted image
+    sides_[i] = a > 0.5f ? SIDE_INNER : SIDE_OUTER;
+
+    if (a <= 0.0f || a >= 1.0f)
+      dist_[i] = unreached;
+    else if (sides_[i] == SIDE_INNER)
+      dist_[i] = edgeDistance(gradX_[i], gradY_[i], 1.0f - a);
+    else
+      dist_[i] = edgeDistance(gradX_[i], gradY_[i], a);
+  }
+
+  // propagates closest edge pixel from the neighbor i + (ox, oy)
+  struct
+  {
+    const SDFF_EdtAA * owner;
+    float * dist;
+    short * distX;
+    short * distY;
+    const unsigned char * sides;
+    int width;
+    float epsilon;
+    float cutoff;
+
+    void operator()(int i, int ox, int oy)
+    {
+      // pixels inside can not get closer
+      if (dist[i] <= 0.0f)
+        return;
+
+      int c = i + ox + oy * width;
+      int side = sides[i];
+      int cdx = 0;
+      int cdy = 0;
+
+      // a neighbor of the other side is an edge pixel of this one, a neighbor of the same side which has not
+      // reached any edge yet has nothing to offer, nor has the padding
+      if (sides[c] == side)
+      {
+        if (dist[c] >= cutoff)
+          return;
+
+        cdx = distX[c];
+        cdy = distY[c];
+      }
+      else if (sides[c] == SIDE_NONE)
+        return;
+
+      // the same closest edge pixel gives the same distance
+      if (c - cdx - cdy * width == i - distX[i] - distY[i] * width)
+        return;
+
+      int ndx = cdx - ox;
+      int ndy = cdy - oy;
+
+      // the edge is less than 0.71 nearer than the center of its pixel, so farther centers can not give a closer edge
+      float reach = dist[i] - epsilon + 0.75f;
+
+      if (float(ndx * ndx + ndy * ndy) >= reach * reach)
+        return;
+
+      float newDist = owner->distance(width, c, cdx, cdy, ndx, ndy, side == SIDE_INNER);
+
+      if (newDist < dist[i] - epsilon)
+      {
+        dist[i] = newDist;
+        distX[i] = (short)ndx;
+        distY[i] = (short)ndy;
+      }
+    }
+  } relax = { this, dist_.data(), distX_.data(), distY_.data(), sides_.data(), paddedWidth, epsilon, band ? band + 2.0f : unreached };
+
+  // forward pass
+  for (int y = 1; y <= height; y++)
+  {
+    int row = y * paddedWidth;
+
+    for (int i = row + 1; i <= row + width; i++)
+    {
+      relax(i, 0, -1);
+      relax(i, -1, -1);
+      relax(i, 1, -1);
+      relax(i, -1, 0);
+    }
+
+    for (int i = row + width; i > row; i--)
+      relax(i, 1, 0);
+  }
+
+  // backward pass
+  for (int y = height; y >= 1; y--)
+  {
+    int row = y * paddedWidth;
+
+    for (int i = row + width; i > row; i--)
+    {
+      relax(i, 0, 1);
+      relax(i, 1, 1);
+      relax(i, -1, 1);
+      relax(i, 1, 0);
+    }
+
+    for (int i = row + 1; i <= row + width; i++)
+      relax(i, -1, 0);
+  }
+}
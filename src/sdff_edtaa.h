@@ -0,0 +1,65 @@
+#pragma once
+
+// Signed distance transform of anti-aliased coverage images.
+// Coverage of edge pixels is used to estimate the sub-pixel edge position, so glyphs
+// rendered at a fraction of the size needed by the mono transform give comparable accuracy.
+class SDFF_EdtAA
+{
+public:
+  typedef std::vector<float> DistanceFieldVector;
+
+  // coverage is an 8-bit image (255 - fully inside), result is padded by falloff on each side,
+  // distances are in pixels, positive outside of the glyph; a nonzero band clamps them to [-band, band]
+  // and leaves the pixels past it mostly untouched
+  float createSdf(const unsigned char * coverage, int coverageWidth, int coverageHeight, int pitch, int falloff, int band, DistanceFieldVector & result);
+  // transforms only the padded rows [firstRow, firstRow + rowCount) as if there were no coverage outside of them,
+  // result holds rowCount rows
+  float createSdf(const unsigned char * coverage, int coverageWidth, int coverageHeight, int pitch, int falloff, int band, int firstRow, int rowCount, DistanceFieldVector & result);
+  // working memory per pixel of the transformed rows: image, gradient, distance, nearest pixel offsets, side and the result
+  static int pixelBytes() { return 5 * (int)sizeof(float) + 2 * (int)sizeof(short) + 1; }
+
+private:
+  enum Side
+  {
+    SIDE_NONE = 0,
+    SIDE_OUTER = 1,
+    SIDE_INNER = 2
+  };
+
+  // unit direction with absolute components, the larger one first, and the coverage below which
+  // the edge orthogonal to it cuts a corner of the pixel
+  struct Direction
+  {
+    float gx;
+    float gy;
+    float a1;
+  };
+
+  // length and direction of a diagonal offset between pixels
+  struct Offset
+  {
+    float length;
+    Direction direction;
+  };
+
+  // offsets with both components below it are looked up instead of computed
+  static const int offsetRadius = 64;
+
+  // per pixel vectors have a pixel of padding around the transformed rows, so neighbors need no bounds checks
+  std::vector<float> image_;
+  std::vector<float> gradX_;
+  std::vector<float> gradY_;
+  std::vector<short> distX_;
+  std::vector<short> distY_;
+  std::vector<float> dist_;
+  std::vector<unsigned char> sides_;
+  std::vector<Offset> offsets_;
+
+  void computeGradient(int width, int height);
+  void transform(int width, int height, int band);
+  static float edgeDistance(float gx, float gy, float a);
+  static float unitEdgeDistance(float gx, float gy, float a);
+  static float unitEdgeDistance(const Direction & direction, float a);
+  static Direction unitDirection(float gx, float gy);
+  float distance(int width, int c, int xc, int yc, int xi, int yi, bool inner) const;
+};
@@ -66,6 +66,8 @@ int SDFF_Font::save(const char * fileName) const
     writer.Double(glyph.right);
     writer.String("bottom");
     writer.Double(glyph.bottom);
+    writer.String("page");
+    writer.Int(glyph.page);
     writer.String("bearingX");
     writer.Double(glyph.bearingX);
     writer.String("bearingY");
@@ -146,6 +148,8 @@ int SDFF_Font::load(const char * fileName)
       getJsonValue(*glyphIt, "right", &glyph.right);
       getJsonValue(*glyphIt, "top", &glyph.top);
       getJsonValue(*glyphIt, "bottom", &glyph.bottom);
+      // files saved before pages have a single one
+      glyph.page = glyphIt->HasMember("page") ? (*glyphIt)["page"].GetInt() : 0;
       getJsonValue(*glyphIt, "bearingX", &glyph.bearingX);
       getJsonValue(*glyphIt, "bearingY", &glyph.bearingY);
       getJsonValue(*glyphIt, "advance", &glyph.advance);
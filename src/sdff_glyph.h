@@ -3,6 +3,21 @@
 class SDFF_Glyph
 {
 public:
+  SDFF_Glyph() :
+    left(0.0f),
+    top(0.0f),
+    right(0.0f),
+    bottom(0.0f),
+    bearingX(0.0f),
+    bearingY(0.0f),
+    advance(0.0f),
+    width(0.0f),
+    height(0.0f),
+    page(0)
+  {
+
+  }
+
   float left;
   float top;
   float right;
@@ -12,4 +27,6 @@ public:
   float advance;
   float width;
   float height;
+  // atlas page of the glyph, the layer of a texture array
+  int page;
 };
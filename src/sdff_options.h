@@ -0,0 +1,80 @@
+#pragma once
+
+#include "sdff_simd.h"
+#include "sdff_resampler.h"
+#include "sdff_transform.h"
+
+// How the source glyph is turned into a distance field
+enum SDFF_Mode
+{
+  // 1-bit rendering and exact euclidean transform, needs large source sizes (2048 by default)
+  SDFF_MODE_MONO_EDT = 0,
+  // anti-aliased rendering with sub-pixel edge estimation, comparable quality at 256-512 source size
+  SDFF_MODE_AA_EDT,
+  // no rasterization, distances to the outline curves are computed at every output texel
+  SDFF_MODE_OUTLINE,
+  // multi-channel field from the outline, 3 channels whose median is the distance, keeps corners sharp
+  SDFF_MODE_MSDF,
+  // MSDF with the true distance in the 4th channel
+  SDFF_MODE_MTSDF,
+  // 1-bit rendering, exact distances only at texel samples instead of averaging the whole transform,
+  // much faster at large source sizes for point sampled quality
+  SDFF_MODE_MONO_SAMPLED
+};
+
+// Optional builder settings, defaults are suitable for most cases
+class SDFF_Options
+{
+public:
+  SDFF_Options() :
+    mode(SDFF_MODE_MONO_EDT),
+    threadCount(0),
+    maxSimdLevel(SDFF_SIMD_AVX2),
+    narrowBand(true),
+    filter(SDFF_FILTER_BOX),
+    supersampling(1),
+    edgeCorrection(false),
+    normals(false),
+    transform(SDFF_TRANSFORM_MEIJSTER),
+    oversampling(0),
+    minSourceFontSize(0),
+    maxSourceFontSize(0),
+    maxTransformMemory(0)
+  {
+
+  }
+
+  SDFF_Mode mode;
+  // number of threads used for building, 0 means all hardware threads
+  int threadCount;
+  // highest instruction set used by the distance transform kernels, lower it to validate against the scalar reference
+  SDFF_SimdLevel maxSimdLevel;
+  // mono transform clamps distances to the band where the quantized output saturates, the output is the same as without it
+  bool narrowBand;
+  // downsampling filter of the mono and anti-aliased modes, sharper filters keep the same error at a smaller sdfFontSize;
+  // the band applies only to filters without negative weights
+  SDFF_Filter filter;
+  // samples per texel side of the sampled mode, a texel averages supersampling x supersampling distances
+  int supersampling;
+  // mono transform measures distances to the square of the nearest pixel found by the feature transform
+  // instead of its center, which moves the edge from the centers of the boundary ink pixels to halfway between pixels
+  bool edgeCorrection;
+  // mono mode adds 2 channels with the outward normal of the nearest edge, x right and y down mapped from [-1, 1] to [1, 255];
+  // the transform keeps the nearest pixel of every source pixel for it (4 bytes per pixel and worker), needs Meijster
+  bool normals;
+  // distance transform engine of the mono mode, Meijster is the fastest and the only one streamed into the downsampled field,
+  // the others transform the whole field first and are there for comparison; edge correction needs Meijster
+  SDFF_Transform transform;
+  // source pixels per output texel of the raster modes, every glyph is rendered at the smallest size giving it,
+  // 0 renders all glyphs at sourceFontSize; 16 or more keeps the output of a 2048 source at sdfFontSize 64 visually the same
+  float oversampling;
+  // bounds of the per glyph source size, 0 means no lower bound and sourceFontSize as the upper one
+  int minSourceFontSize;
+  int maxSourceFontSize;
+  // memory limit in megabytes of a worker transforming the whole field, which the anti-aliased mode and the mono engines
+  // other than Meijster do; over it the field is transformed in overlapping bands of rows with the same output.
+  // Needs the narrow band; a band with its overlaps is at least 3 narrow bands high (5 for approximate transforms),
+  // the limit is exceeded when that does not fit.
+  // The fused Meijster transform keeps only a few rows at a time and does not need it. 0 means no limit
+  int maxTransformMemory;
+};
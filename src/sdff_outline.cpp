@@ -0,0 +1,752 @@
+#include "static_headers.h"
+
+#include "sdff_outline.h"
+
+bool SDFF_Outline::decompose(const FT_Outline & outline)
+{
+  FT_Outline_Funcs funcs;
+  funcs.move_to = moveTo;
+  funcs.line_to = lineTo;
+  funcs.conic_to = conicTo;
+  funcs.cubic_to = cubicTo;
+  funcs.shift = 0;
+  funcs.delta = 0;
+
+  segments_.clear();
+  contourStarts_.clear();
+  current_ = glm::vec2(0.0f);
+  evenOdd_ = (outline.flags & FT_OUTLINE_EVEN_ODD_FILL) != 0;
+  fillLeft_ = FT_Outline_Get_Orientation(const_cast<FT_Outline *>(&outline)) == FT_ORIENTATION_FILL_LEFT;
+
+  // contours are closed by FreeType, so segments form closed loops
+  FT_Error ftError = FT_Outline_Decompose(const_cast<FT_Outline *>(&outline), &funcs, this);
+  assert(!ftError);
+
+  if (ftError)
+    return false;
+
+  colorEdges();
+  return true;
+}
+
+
+int SDFF_Outline::moveTo(const FT_Vector * to, void * user)
+{
+  SDFF_Outline * outline = (SDFF_Outline *)user;
+  outline->current_ = glm::vec2(to->x / 64.0f, to->y / 64.0f);
+  outline->contourStarts_.push_back((int)outline->segments_.size());
+  return 0;
+}
+
+
+int SDFF_Outline::lineTo(const FT_Vector * to, void * user)
+{
+  ((SDFF_Outline *)user)->addSegment(SEGMENT_LINE, &to, 1);
+  return 0;
+}
+
+
+int SDFF_Outline::conicTo(const FT_Vector * control, const FT_Vector * to, void * user)
+{
+  const FT_Vector * points[] = { control, to };
+  ((SDFF_Outline *)user)->addSegment(SEGMENT_CONIC, points, 2);
+  return 0;
+}
+
+
+int SDFF_Outline::cubicTo(const FT_Vector * control1, const FT_Vector * control2, const FT_Vector * to, void * user)
+{
+  const FT_Vector * points[] = { control1, control2, to };
+  ((SDFF_Outline *)user)->addSegment(SEGMENT_CUBIC, points, 3);
+  return 0;
+}
+
+
+void SDFF_Outline::addSegment(SegmentType type, const FT_Vector * const * points, int count)
+{
+  Segment segment;
+  segment.type = type;
+  segment.color = COLOR_WHITE;
+  segment.points[0] = current_;
+  segment.boundsMin = current_;
+  segment.boundsMax = current_;
+
+  for (int i = 0; i < count; i++)
+  {
+    glm::vec2 point(points[i]->x / 64.0f, points[i]->y / 64.0f);
+    segment.points[i + 1] = point;
+    segment.boundsMin = glm::min(segment.boundsMin, point);
+    segment.boundsMax = glm::max(segment.boundsMax, point);
+  }
+
+  current_ = segment.points[count];
+
+  // zero length lines change neither distance nor winding
+  if (type != SEGMENT_LINE || segment.points[0] != segment.points[1])
+    segments_.push_back(segment);
+}
+
+
+void SDFF_Outline::createSdf(float left, float top, float stepX, float stepY, int width, int height, float maxDistance, DistanceFieldVector & result)
+{
+  assert(width > 0 && height > 0);
+  assert(maxDistance > 0.0f);
+  result.resize(width * height);
+  int segmentCount = (int)segments_.size();
+  int closestSegment = 0;
+
+  for (int y = 0; y < height; y++)
+  {
+    float py = rowPosition(top - (y + 0.5f) * stepY);
+    findCrossings(py);
+    int crossingIndex = 0;
+    int winding = 0;
+
+    for (int x = 0; x < width; x++)
+    {
+      glm::vec2 p(left + (x + 0.5f) * stepX, py);
+
+      while (crossingIndex < (int)crossings_.size() && crossings_[crossingIndex].x < p.x)
+        winding += crossings_[crossingIndex++].winding;
+
+      // the closest segment of the previous texel is a good first guess, it makes the bounds test below reject more
+      float minDistance = maxDistance * maxDistance;
+
+      float t;
+
+      if (closestSegment < segmentCount)
+        minDistance = glm::min(minDistance, squaredDistance(segments_[closestSegment], p, t));
+
+      for (int i = 0; i < segmentCount; i++)
+      {
+        const Segment & segment = segments_[i];
+        glm::vec2 boundsOffset = glm::max(glm::max(segment.boundsMin - p, p - segment.boundsMax), glm::vec2(0.0f));
+
+        if (glm::dot(boundsOffset, boundsOffset) >= minDistance)
+          continue;
+
+        float distance = squaredDistance(segment, p, t);
+
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestSegment = i;
+        }
+      }
+
+      bool inside = evenOdd_ ? (winding & 1) != 0 : winding != 0;
+      float distance = std::sqrt(minDistance);
+      result[x + y * width] = inside ? -distance : distance;
+    }
+  }
+}
+
+
+void SDFF_Outline::createMsdf(float left, float top, float stepX, float stepY, int width, int height, float maxDistance, int channels, DistanceFieldVector & result)
+{
+  assert(width > 0 && height > 0);
+  assert(maxDistance > 0.0f);
+  assert(channels == 3 || channels == 4);
+  result.resize(width * height * channels);
+  trueDistances_.resize(width * height);
+  int segmentCount = (int)segments_.size();
+
+  for (int y = 0; y < height; y++)
+  {
+    float py = rowPosition(top - (y + 0.5f) * stepY);
+    findCrossings(py);
+    int crossingIndex = 0;
+    int winding = 0;
+
+    for (int x = 0; x < width; x++)
+    {
+      glm::vec2 p(left + (x + 0.5f) * stepX, py);
+
+      while (crossingIndex < (int)crossings_.size() && crossings_[crossingIndex].x < p.x)
+        winding += crossings_[crossingIndex++].winding;
+
+      float minDistances[3] = { maxDistance * maxDistance, maxDistance * maxDistance, maxDistance * maxDistance };
+      float closestT[3] = { 0.0f, 0.0f, 0.0f };
+      float closestOrthogonality[3] = { -1.0f, -1.0f, -1.0f };
+      int closestSegments[3] = { -1, -1, -1 };
+      // segments farther than the worst channel can not improve any of them
+      float limit = maxDistance * maxDistance;
+
+      for (int i = 0; i < segmentCount; i++)
+      {
+        const Segment & segment = segments_[i];
+        glm::vec2 boundsOffset = glm::max(glm::max(segment.boundsMin - p, p - segment.boundsMax), glm::vec2(0.0f));
+
+        if (glm::dot(boundsOffset, boundsOffset) >= limit)
+          continue;
+
+        float t;
+        float distance = squaredDistance(segment, p, t);
+        float segmentOrthogonality = -1.0f;
+
+        for (int c = 0; c < 3; c++)
+        {
+          if (!(segment.color & (1 << c)))
+            continue;
+
+          bool closer = distance < minDistances[c];
+
+          // neighbors sharing the closest end point are told apart by the angle, the more orthogonal one wins
+          if (closestSegments[c] >= 0 && glm::abs(distance - minDistances[c]) <= 1e-4f * minDistances[c])
+          {
+            if (segmentOrthogonality < 0.0f)
+              segmentOrthogonality = orthogonality(segment, p, t);
+
+            if (closestOrthogonality[c] < 0.0f)
+              closestOrthogonality[c] = orthogonality(segments_[closestSegments[c]], p, closestT[c]);
+
+            closer = segmentOrthogonality < closestOrthogonality[c];
+          }
+
+          if (closer)
+          {
+            minDistances[c] = distance;
+            closestT[c] = t;
+            closestSegments[c] = i;
+            closestOrthogonality[c] = segmentOrthogonality;
+          }
+        }
+
+        limit = glm::max(minDistances[0], glm::max(minDistances[1], minDistances[2]));
+      }
+
+      bool inside = evenOdd_ ? (winding & 1) != 0 : winding != 0;
+      float trueDistance = std::sqrt(glm::min(minDistances[0], glm::min(minDistances[1], minDistances[2])));
+      trueDistance = inside ? -trueDistance : trueDistance;
+      trueDistances_[x + y * width] = trueDistance;
+      float * texel = result.data() + (x + y * width) * channels;
+
+      for (int c = 0; c < 3; c++)
+      {
+        if (closestSegments[c] >= 0)
+        {
+          float distance = signedPseudoDistance(segments_[closestSegments[c]], p, closestT[c], std::sqrt(minDistances[c]));
+          texel[c] = glm::clamp(distance, -maxDistance, maxDistance);
+        }
+        else
+          texel[c] = inside ? -maxDistance : maxDistance;
+      }
+
+      float median = glm::max(glm::min(texel[0], texel[1]), glm::min(glm::max(texel[0], texel[1]), texel[2]));
+
+      // the winding number is exact, texels with the wrong median sign would show up as artifacts
+      if (inside ? median > 0.0f : median < 0.0f)
+        texel[0] = texel[1] = texel[2] = trueDistance;
+
+      if (channels == 4)
+        texel[3] = trueDistance;
+    }
+  }
+
+  correctErrors(stepX, stepY, width, height, channels, result);
+}
+
+
+// Texels farther from the outline than a texel diagonal are corners of no texel square the edge crosses,
+// so their channels can not shape it; the pseudo-distances there run far from the true distance around corners
+// and take it instead. Closer texels are compared with their 4 neighbors: two channels changing by more than
+// the texel step switched to other segments in between, and interpolating them would draw an edge there.
+// The texel of such a pair farther from the edge gets the true distance too (clash detection of msdfgen).
+void SDFF_Outline::correctErrors(float stepX, float stepY, int width, int height, int channels, DistanceFieldVector & result)
+{
+  const float clashThreshold = 1.001f;
+  float diagonal = std::sqrt(stepX * stepX + stepY * stepY);
+  errors_.assign(width * height, false);
+
+  for (int y = 0; y < height; y++)
+  for (int x = 0; x < width; x++)
+  {
+    int i = x + y * width;
+    const float * texel = result.data() + i * channels;
+
+    if (glm::abs(trueDistances_[i]) > diagonal)
+      errors_[i] = true;
+    else
+      errors_[i] = (x > 0 && clash(texel, texel - channels, clashThreshold * stepX)) ||
+                   (x < width - 1 && clash(texel, texel + channels, clashThreshold * stepX)) ||
+                   (y > 0 && clash(texel, texel - width * channels, clashThreshold * stepY)) ||
+                   (y < height - 1 && clash(texel, texel + width * channels, clashThreshold * stepY));
+  }
+
+  for (int i = 0; i < width * height; i++)
+  {
+    if (errors_[i])
+    {
+      float * texel = result.data() + i * channels;
+      texel[0] = texel[1] = texel[2] = trueDistances_[i];
+    }
+  }
+}
+
+
+// Whether texel a and its neighbor b clash: the two channels which change the most between them change
+// by more than the threshold, b has not been equalized yet and a is the one farther from the edge
+bool SDFF_Outline::clash(const float * a, const float * b, float threshold)
+{
+  float a0 = a[0];
+  float a1 = a[1];
+  float a2 = a[2];
+  float b0 = b[0];
+  float b1 = b[1];
+  float b2 = b[2];
+
+  // channel pairs sorted by decreasing change
+  if (glm::abs(b0 - a0) < glm::abs(b1 - a1))
+  {
+    std::swap(a0, a1);
+    std::swap(b0, b1);
+  }
+
+  if (glm::abs(b1 - a1) < glm::abs(b2 - a2))
+  {
+    std::swap(a1, a2);
+    std::swap(b1, b2);
+
+    if (glm::abs(b0 - a0) < glm::abs(b1 - a1))
+    {
+      std::swap(a0, a1);
+      std::swap(b0, b1);
+    }
+  }
+
+  return glm::abs(b1 - a1) >= threshold && !(b0 == b1 && b0 == b2) && glm::abs(a2) >= glm::abs(b2);
+}
+
+
+// Moves the row slightly if it passes through an end point of a segment,
+// so every crossing of the row is inside of exactly one segment
+float SDFF_Outline::rowPosition(float y) const
+{
+  const float minOffset = 1.0f / 1024;
+
+  for (int attempt = 0; attempt < 16; attempt++)
+  {
+    bool clear = true;
+
+    for (size_t i = 0; i < segments_.size() && clear; i++)
+      clear = glm::abs(segments_[i].points[0].y - y) >= minOffset;
+
+    if (clear)
+      break;
+
+    y += 3.0f * minOffset;
+  }
+
+  return y;
+}
+
+
+void SDFF_Outline::findCrossings(float y)
+{
+  crossings_.clear();
+
+  for (size_t i = 0; i < segments_.size(); i++)
+  {
+    const Segment & segment = segments_[i];
+    const glm::vec2 * p = segment.points;
+
+    if (y < segment.boundsMin.y || y > segment.boundsMax.y)
+      continue;
+
+    if (segment.type == SEGMENT_LINE)
+    {
+      if ((p[0].y <= y && y < p[1].y) || (p[1].y <= y && y < p[0].y))
+      {
+        float t = (y - p[0].y) / (p[1].y - p[0].y);
+        Crossing crossing = { p[0].x + t * (p[1].x - p[0].x), p[1].y > p[0].y ? 1 : -1 };
+        crossings_.push_back(crossing);
+      }
+
+      continue;
+    }
+
+    double roots[3];
+    int rootCount;
+
+    // y(t) - y = 0 in the power basis
+    if (segment.type == SEGMENT_CONIC)
+      rootCount = solveQuadratic(p[0].y - 2.0 * p[1].y + p[2].y, 2.0 * (p[1].y - p[0].y), p[0].y - y, roots);
+    else
+      rootCount = solveCubic(-p[0].y + 3.0 * p[1].y - 3.0 * p[2].y + p[3].y, 3.0 * p[0].y - 6.0 * p[1].y + 3.0 * p[2].y,
+                             3.0 * (p[1].y - p[0].y), p[0].y - y, roots);
+
+    for (int r = 0; r < rootCount; r++)
+    {
+      float t = (float)roots[r];
+
+      if (t < 0.0f || t >= 1.0f)
+        continue;
+
+      float s = 1.0f - t;
+      float x, dy;
+
+      if (segment.type == SEGMENT_CONIC)
+      {
+        x = s * s * p[0].x + 2.0f * s * t * p[1].x + t * t * p[2].x;
+        dy = s * (p[1].y - p[0].y) + t * (p[2].y - p[1].y);
+      }
+      else
+      {
+        x = s * s * s * p[0].x + 3.0f * s * s * t * p[1].x + 3.0f * s * t * t * p[2].x + t * t * t * p[3].x;
+        dy = s * s * (p[1].y - p[0].y) + 2.0f * s * t * (p[2].y - p[1].y) + t * t * (p[3].y - p[2].y);
+      }
+
+      // tangent touch does not change the winding
+      if (dy != 0.0f)
+      {
+        Crossing crossing = { x, dy > 0.0f ? 1 : -1 };
+        crossings_.push_back(crossing);
+      }
+    }
+  }
+
+  std::sort(crossings_.begin(), crossings_.end());
+}
+
+
+float SDFF_Outline::squaredDistance(const Segment & segment, const glm::vec2 & p, float & closestT)
+{
+  const glm::vec2 * points = segment.points;
+
+  if (segment.type == SEGMENT_LINE)
+  {
+    glm::vec2 direction = points[1] - points[0];
+    closestT = glm::clamp(glm::dot(p - points[0], direction) / glm::dot(direction, direction), 0.0f, 1.0f);
+    glm::vec2 offset = points[0] + closestT * direction - p;
+    return glm::dot(offset, offset);
+  }
+
+  glm::vec2 offset0 = points[0] - p;
+  glm::vec2 offset1 = points[segment.type == SEGMENT_CONIC ? 2 : 3] - p;
+  float minDistance = glm::dot(offset0, offset0);
+  closestT = 0.0f;
+
+  if (glm::dot(offset1, offset1) < minDistance)
+  {
+    minDistance = glm::dot(offset1, offset1);
+    closestT = 1.0f;
+  }
+
+  if (segment.type == SEGMENT_CONIC)
+  {
+    // B(t) - p = m + 2ta + t^2b, the closest point is a root of dot(B(t) - p, B'(t)) = 0
+    glm::vec2 m = offset0;
+    glm::vec2 a = points[1] - points[0];
+    glm::vec2 b = points[2] - 2.0f * points[1] + points[0];
+    double roots[3];
+    int rootCount = solveCubic(glm::dot(b, b), 3.0 * glm::dot(a, b), 2.0 * glm::dot(a, a) + glm::dot(m, b), glm::dot(m, a), roots);
+
+    for (int r = 0; r < rootCount; r++)
+    {
+      float t = (float)roots[r];
+
+      if (t > 0.0f && t < 1.0f)
+      {
+        glm::vec2 offset = m + (2.0f * t) * a + (t * t) * b;
+        float distance = glm::dot(offset, offset);
+
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestT = t;
+        }
+      }
+    }
+
+    return minDistance;
+  }
+
+  // cubic: the closest of uniform samples is refined by Newton iterations on dot(B(t) - p, B'(t)) = 0
+  const int sampleCount = 8;
+  glm::vec2 c1 = 3.0f * (points[1] - points[0]);
+  glm::vec2 c2 = 3.0f * (points[2] - 2.0f * points[1] + points[0]);
+  glm::vec2 c3 = points[3] - 3.0f * points[2] + 3.0f * points[1] - points[0];
+  float bestT = 0.0f;
+  float bestDistance = FLT_MAX;
+
+  for (int i = 0; i <= sampleCount; i++)
+  {
+    float t = float(i) / sampleCount;
+    glm::vec2 offset = offset0 + t * (c1 + t * (c2 + t * c3));
+    float distance = glm::dot(offset, offset);
+
+    if (distance < bestDistance)
+    {
+      bestDistance = distance;
+      bestT = t;
+    }
+  }
+
+  float t = bestT;
+
+  for (int iteration = 0; iteration < 4; iteration++)
+  {
+    glm::vec2 offset = offset0 + t * (c1 + t * (c2 + t * c3));
+    glm::vec2 d1 = c1 + t * (2.0f * c2 + 3.0f * t * c3);
+    glm::vec2 d2 = 2.0f * c2 + 6.0f * t * c3;
+    float denominator = glm::dot(d1, d1) + glm::dot(offset, d2);
+
+    if (denominator <= 0.0f)
+      break;
+
+    t = glm::clamp(t - glm::dot(offset, d1) / denominator, 0.0f, 1.0f);
+  }
+
+  glm::vec2 offset = offset0 + t * (c1 + t * (c2 + t * c3));
+  float distance = glm::dot(offset, offset);
+
+  if (distance < minDistance)
+  {
+    minDistance = distance;
+    closestT = t;
+  }
+
+  return minDistance;
+}
+
+
+// Edge coloring after msdfgen by Viktor Chlumsky: contours without corners stay white,
+// colors switch at every corner and the last edge never gets the color of the first one
+void SDFF_Outline::colorEdges()
+{
+  // sine of the maximal angle between tangents of a smooth joint
+  const float crossThreshold = 0.1411f;
+  int seed = 0;
+  std::vector<int> corners;
+
+  for (size_t contour = 0; contour < contourStarts_.size(); contour++)
+  {
+    int first = contourStarts_[contour];
+    int last = contour + 1 < contourStarts_.size() ? contourStarts_[contour + 1] : (int)segments_.size();
+    int count = last - first;
+    corners.clear();
+
+    for (int i = 0; i < count; i++)
+    {
+      glm::vec2 in = glm::normalize(direction(segments_[first + (i + count - 1) % count], 1.0f));
+      glm::vec2 out = glm::normalize(direction(segments_[first + i], 0.0f));
+
+      if (glm::dot(in, out) <= 0.0f || glm::abs(in.x * out.y - in.y * out.x) > crossThreshold)
+        corners.push_back(i);
+    }
+
+    if (corners.size() == 1 && count >= 3)
+    {
+      // teardrop, the contour is split into three parts around the only corner
+      int colors[3] = { COLOR_WHITE, COLOR_WHITE, COLOR_WHITE };
+      switchColor(colors[0], seed, 0);
+      colors[2] = colors[0];
+      switchColor(colors[2], seed, 0);
+
+      for (int i = 0; i < count; i++)
+      {
+        int third = int(3.0f + 2.875f * i / (count - 1) - 1.4375f + 0.5f) - 3;
+        segments_[first + (corners[0] + i) % count].color = colors[1 + third];
+      }
+    }
+    else if (corners.size() > 1)
+    {
+      int cornerCount = (int)corners.size();
+      int spline = 0;
+      int color = COLOR_WHITE;
+      switchColor(color, seed, 0);
+      int initialColor = color;
+
+      for (int i = 0; i < count; i++)
+      {
+        int index = (corners[0] + i) % count;
+
+        if (spline + 1 < cornerCount && corners[spline + 1] == index)
+        {
+          spline++;
+          switchColor(color, seed, spline == cornerCount - 1 ? initialColor : 0);
+        }
+
+        segments_[first + index].color = color;
+      }
+    }
+  }
+}
+
+
+void SDFF_Outline::switchColor(int & color, int & seed, int banned)
+{
+  int combined = color & banned;
+
+  if (combined == COLOR_RED || combined == COLOR_GREEN || combined == COLOR_BLUE)
+  {
+    color = combined ^ COLOR_WHITE;
+    return;
+  }
+
+  if (color == COLOR_WHITE)
+  {
+    const int start[3] = { COLOR_CYAN, COLOR_MAGENTA, COLOR_YELLOW };
+    color = start[seed % 3];
+    seed /= 3;
+    return;
+  }
+
+  int shifted = color << (1 + (seed & 1));
+  color = (shifted | shifted >> 3) & COLOR_WHITE;
+  seed >>= 1;
+}
+
+
+// Distance with the sign of the side of the segment, beyond its ends the segment is extended along
+// the end tangent, so that channels of the two edges meeting at a corner agree near the corner
+float SDFF_Outline::signedPseudoDistance(const Segment & segment, const glm::vec2 & p, float t, float distance) const
+{
+  glm::vec2 tangent = direction(segment, t);
+  glm::vec2 offset = p - point(segment, t);
+  float side = tangent.x * offset.y - tangent.y * offset.x;
+  float result = (side > 0.0f) == fillLeft_ ? -distance : distance;
+
+  if (t <= 0.0f || t >= 1.0f)
+  {
+    glm::vec2 endTangent = glm::normalize(tangent);
+    float along = glm::dot(offset, endTangent);
+
+    if (t <= 0.0f ? along < 0.0f : along > 0.0f)
+    {
+      float pseudoDistance = endTangent.x * offset.y - endTangent.y * offset.x;
+
+      if (glm::abs(pseudoDistance) <= distance)
+        result = (pseudoDistance > 0.0f) == fillLeft_ ? -glm::abs(pseudoDistance) : glm::abs(pseudoDistance);
+    }
+  }
+
+  return result;
+}
+
+
+glm::vec2 SDFF_Outline::point(const Segment & segment, float t)
+{
+  const glm::vec2 * p = segment.points;
+  float s = 1.0f - t;
+
+  if (segment.type == SEGMENT_LINE)
+    return s * p[0] + t * p[1];
+  else if (segment.type == SEGMENT_CONIC)
+    return (s * s) * p[0] + (2.0f * s * t) * p[1] + (t * t) * p[2];
+  else
+    return (s * s * s) * p[0] + (3.0f * s * s * t) * p[1] + (3.0f * s * t * t) * p[2] + (t * t * t) * p[3];
+}
+
+
+// Tangent direction, not normalized. Coincident control points at the ends are skipped.
+glm::vec2 SDFF_Outline::direction(const Segment & segment, float t)
+{
+  const glm::vec2 * p = segment.points;
+  int last = segment.type == SEGMENT_LINE ? 1 : segment.type == SEGMENT_CONIC ? 2 : 3;
+  float s = 1.0f - t;
+  glm::vec2 result;
+
+  if (segment.type == SEGMENT_LINE)
+    return p[1] - p[0];
+  else if (segment.type == SEGMENT_CONIC)
+    result = s * (p[1] - p[0]) + t * (p[2] - p[1]);
+  else
+    result = (s * s) * (p[1] - p[0]) + (2.0f * s * t) * (p[2] - p[1]) + (t * t) * (p[3] - p[2]);
+
+  for (int i = 1; i < last && result == glm::vec2(0.0f); i++)
+    result = t < 0.5f ? p[i + 1] - p[0] : p[last] - p[last - i - 1];
+
+  return result;
+}
+
+
+// |cos| of the angle between the segment tangent and the direction to p, 0 when p lies on the segment normal
+float SDFF_Outline::orthogonality(const Segment & segment, const glm::vec2 & p, float t)
+{
+  glm::vec2 offset = p - point(segment, t);
+  float length = glm::length(offset);
+
+  if (length == 0.0f)
+    return 0.0f;
+
+  return glm::abs(glm::dot(glm::normalize(direction(segment, t)), offset / length));
+}
+
+
+// Real roots of at^2 + bt + c = 0, returns their count
+int SDFF_Outline::solveQuadratic(double a, double b, double c, double * roots)
+{
+  if (a == 0.0)
+  {
+    if (b == 0.0)
+      return 0;
+
+    roots[0] = -c / b;
+    return 1;
+  }
+
+  double discriminant = b * b - 4.0 * a * c;
+
+  if (discriminant < 0.0)
+    return 0;
+
+  // avoids cancellation of b and the square root
+  double q = -0.5 * (b + (b < 0.0 ? -std::sqrt(discriminant) : std::sqrt(discriminant)));
+  roots[0] = q / a;
+
+  if (q == 0.0)
+    return 1;
+
+  roots[1] = c / q;
+  return 2;
+}
+
+
+// Real roots of at^3 + bt^2 + ct + d = 0, returns their count
+int SDFF_Outline::solveCubic(double a, double b, double c, double d, double * roots)
+{
+  if (glm::abs(a) <= 1e-9 * (glm::abs(b) + glm::abs(c) + glm::abs(d)))
+    return solveQuadratic(b, c, d, roots);
+
+  b /= a;
+  c /= a;
+  d /= a;
+
+  // depressed cubic x^3 + px + q = 0, t = x - b / 3
+  double p = c - b * b / 3.0;
+  double q = 2.0 * b * b * b / 27.0 - b * c / 3.0 + d;
+  double shift = -b / 3.0;
+  double discriminant = q * q / 4.0 + p * p * p / 27.0;
+  int rootCount;
+
+  if (discriminant >= 0.0)
+  {
+    double s = std::sqrt(discriminant);
+    roots[0] = std::cbrt(-0.5 * q + s) + std::cbrt(-0.5 * q - s) + shift;
+    rootCount = 1;
+  }
+  else
+  {
+    const double pi = 3.14159265358979323846;
+    double r = 2.0 * std::sqrt(-p / 3.0);
+    double phi = std::acos(glm::clamp(1.5 * q / p * std::sqrt(-3.0 / p), -1.0, 1.0)) / 3.0;
+
+    for (int k = 0; k < 3; k++)
+      roots[k] = r * std::cos(phi - 2.0 * pi * k / 3.0) + shift;
+
+    rootCount = 3;
+  }
+
+  // one Newton step polishes the closed form roots
+  for (int k = 0; k < rootCount; k++)
+  {
+    double t = roots[k];
+    double derivative = (3.0 * t + 2.0 * b) * t + c;
+
+    if (derivative != 0.0)
+      roots[k] = t - (((t + b) * t + c) * t + d) / derivative;
+  }
+
+  return rootCount;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+// Signed distance field computed directly from the glyph outline, no rasterization involved.
+// Distance is measured to the line, conic and cubic segments, the sign comes from the winding number
+// of the outline along each row of samples, so the cost depends on the output size only.
+// Multi-channel fields keep sharp corners: segments are colored so that the two sides of a corner
+// never share all channels, every channel holds the distance to the closest segment of its color.
+class SDFF_Outline
+{
+public:
+  typedef std::vector<float> DistanceFieldVector;
+
+  // takes segments of the outline, coordinates are converted from 26.6 to pixels
+  bool decompose(const FT_Outline & outline);
+  // Samples a width x height grid, center of the texel (x, y) is at (left + (x + 0.5) * stepX, top - (y + 0.5) * stepY)
+  // in outline pixels. Distances are positive outside of the glyph and clamped to maxDistance.
+  void createSdf(float left, float top, float stepX, float stepY, int width, int height, float maxDistance, DistanceFieldVector & result);
+  // Same grid with 3 interleaved channels whose median is the signed distance,
+  // the 4th channel if requested holds the true signed distance. Texels whose channels would draw false edges
+  // or lie far from the true distance away from the outline hold the true distance in all channels
+  void createMsdf(float left, float top, float stepX, float stepY, int width, int height, float maxDistance, int channels, DistanceFieldVector & result);
+
+private:
+  enum SegmentType
+  {
+    SEGMENT_LINE,
+    SEGMENT_CONIC,
+    SEGMENT_CUBIC
+  };
+
+  enum EdgeColor
+  {
+    COLOR_RED = 1,
+    COLOR_GREEN = 2,
+    COLOR_BLUE = 4,
+    COLOR_YELLOW = COLOR_RED | COLOR_GREEN,
+    COLOR_MAGENTA = COLOR_RED | COLOR_BLUE,
+    COLOR_CYAN = COLOR_GREEN | COLOR_BLUE,
+    COLOR_WHITE = COLOR_RED | COLOR_GREEN | COLOR_BLUE
+  };
+
+  struct Segment
+  {
+    SegmentType type;
+    // channels of the multi-channel field this segment belongs to
+    int color;
+    glm::vec2 points[4];
+    // bounds of the control points, the curve lies inside of them
+    glm::vec2 boundsMin;
+    glm::vec2 boundsMax;
+  };
+
+  struct Crossing
+  {
+    float x;
+    int winding;
+
+    bool operator<(const Crossing & other) const { return x < other.x; }
+  };
+
+  std::vector<Segment> segments_;
+  std::vector<int> contourStarts_;
+  std::vector<Crossing> crossings_;
+  std::vector<float> trueDistances_;
+  std::vector<bool> errors_;
+  glm::vec2 current_;
+  bool evenOdd_;
+  // filled area is on the left side of the segment direction
+  bool fillLeft_;
+
+  static int moveTo(const FT_Vector * to, void * user);
+  static int lineTo(const FT_Vector * to, void * user);
+  static int conicTo(const FT_Vector * control, const FT_Vector * to, void * user);
+  static int cubicTo(const FT_Vector * control1, const FT_Vector * control2, const FT_Vector * to, void * user);
+  void addSegment(SegmentType type, const FT_Vector * const * points, int count);
+
+  void correctErrors(float stepX, float stepY, int width, int height, int channels, DistanceFieldVector & result);
+  static bool clash(const float * a, const float * b, float threshold);
+  float rowPosition(float y) const;
+  void findCrossings(float y);
+  void colorEdges();
+  static void switchColor(int & color, int & seed, int banned);
+  float signedPseudoDistance(const Segment & segment, const glm::vec2 & p, float t, float distance) const;
+  static float squaredDistance(const Segment & segment, const glm::vec2 & p, float & closestT);
+  static glm::vec2 point(const Segment & segment, float t);
+  static glm::vec2 direction(const Segment & segment, float t);
+  static float orthogonality(const Segment & segment, const glm::vec2 & p, float t);
+  static int solveQuadratic(double a, double b, double c, double * roots);
+  static int solveCubic(double a, double b, double c, double d, double * roots);
+};
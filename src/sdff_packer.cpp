@@ -0,0 +1,1012 @@
+#include "static_headers.h"
+
+#include "sdff_packer.h"
+#include "sdff_thread_pool.h"
+
+// Keeps the maximal free rectangles of a bin (MaxRects), a placed rect splits every free one it intersects
+// and the parts contained in another free rect are dropped. Free rects live in a uniform grid, a rect is listed in every
+// cell it overlaps and in the cell of its top left corner; rects spanning many cells, mostly the unbounded ones around
+// the packed area, are kept in a list of their own which every query visits.
+class SDFF_FreeRectsPacker : public SDFF_Packer
+{
+public:
+  SDFF_FreeRectsPacker(SDFF_PackingHeuristic heuristic, int binWidth, int binHeight) : heuristic_(heuristic), binWidth_(binWidth), binHeight_(binHeight), tieRule_(TIE_GROWTH) {}
+
+  bool pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom) override;
+  bool insert(RectVector & rects, int & maxRight, int & maxBottom) override;
+
+private:
+  typedef std::vector<int> IdVector;
+
+  // how equal scores are settled: flags of growing the bounds the least first, then the topmost position or the leftmost one first
+  enum TieRule
+  {
+    TIE_TOP_LEFT = 0,
+    TIE_GROWTH = 1,
+    TIE_LEFT_TOP = 2,
+    TIE_RULE_COUNT = 4
+  };
+
+  RectVector freeRects_;
+  std::vector<bool> alive_;
+  std::vector<int> visits_;
+  std::vector<IdVector> cells_;
+  std::vector<IdVector> corners_;
+  IdVector large_;
+  RectVector splits_;
+  // placed rects in the same grid, only the contact point heuristic looks them up
+  RectVector placed_;
+  std::vector<int> placedVisits_;
+  std::vector<IdVector> placedCells_;
+  // sizes found not to fit, the free space only shrinks, so rects at least as large do not fit either
+  RectVector failed_;
+  SDFF_PackingHeuristic heuristic_;
+  int binWidth_;
+  int binHeight_;
+  int maxRight_;
+  int maxBottom_;
+  int cellSize_;
+  int gridSize_;
+  int visit_;
+  int tieRule_;
+
+  // a rect spanning more than that many cells is cheaper to visit on every query than to list in its cells
+  static const int maxCells = 64;
+
+  int cell(int coordinate) const { return glm::min(coordinate / cellSize_, gridSize_ - 1); }
+  bool large(const Rect & rect) const { return (cell(rect.right()) - cell(rect.left) + 1) * (cell(rect.bottom()) - cell(rect.top) + 1) > maxCells; }
+  void reset(const RectVector & rects, bool wholeBin);
+  void add(const Rect & rect);
+  template <class Func> void query(const Rect & area, Func func);
+  void score(const Rect & freeRect, const Rect & rect, int maxRight, int maxBottom, double & primary, double & secondary);
+  int contact(const Rect & rect);
+};
+
+
+// Keeps the top of the free space along the atlas width as horizontal segments, the space under them is lost.
+// A bounded bin sets the atlas width, otherwise it is picked from the rects area
+class SDFF_SkylinePacker : public SDFF_Packer
+{
+public:
+  SDFF_SkylinePacker(int binWidth, int binHeight) : binWidth_(binWidth), binHeight_(binHeight) {}
+
+  bool pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom) override;
+  bool insert(RectVector & rects, int & maxRight, int & maxBottom) override;
+
+private:
+  struct Segment
+  {
+    int left;
+    int top;
+    int width;
+  };
+
+  std::vector<Segment> skyline_;
+  int binWidth_;
+  int binHeight_;
+  int atlasWidth_;
+  int maxRight_;
+  int maxBottom_;
+
+  void reset(const RectVector & rects, bool powerOfTwo);
+  int fit(int index, int width) const;
+  void place(int index, const Rect & rect);
+};
+
+
+// Runs the heuristics of the free rectangles packer with several sort orders in bins of decreasing size
+// and keeps the layout of the smallest atlas. In a bounded bin it keeps the layout placing the largest area
+// and fills the bin only once, the inserts after the first one place nothing
+class SDFF_DensestPacker : public SDFF_Packer
+{
+public:
+  SDFF_DensestPacker(SDFF_ThreadPool * threadPool, int binWidth, int binHeight) : threadPool_(threadPool), binWidth_(binWidth), binHeight_(binHeight), filled_(false) {}
+
+  bool pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom) override;
+  bool insert(RectVector & rects, int & maxRight, int & maxBottom) override;
+
+private:
+  typedef std::vector<int> IdVector;
+
+  struct Layout
+  {
+    RectVector rects;
+    int maxRight;
+    int maxBottom;
+    bool fits;
+  };
+
+  // sort orders tried with every heuristic
+  static const int orderCount = 5;
+
+  SDFF_ThreadPool * threadPool_;
+  int binWidth_;
+  int binHeight_;
+  bool filled_;
+
+  void run(int count, const float * costs, const SDFF_ThreadPool::TaskFunc & func);
+  void sortOrders(const RectVector & rects, std::vector<IdVector> & orders) const;
+  void runHeuristics(const RectVector & rects, const std::vector<IdVector> & orders, const Rect & bin, bool powerOfTwo, std::vector<Layout> & layouts);
+};
+
+
+static int roundUpToPowerOfTwo(int value)
+{
+  int result = 1;
+
+  while (result < value)
+    result *= 2;
+
+  return result;
+}
+
+
+SDFF_Packer * SDFF_Packer::create(SDFF_Packing packing, SDFF_ThreadPool * threadPool, int binWidth, int binHeight)
+{
+  assert(binWidth > 0 && binHeight > 0);
+  bool bounded = binWidth < INT_MAX || binHeight < INT_MAX;
+
+  switch (packing)
+  {
+  case SDFF_PACKING_FREE_RECTS:
+    return new SDFF_FreeRectsPacker(bounded ? SDFF_HEURISTIC_BEST_SHORT_SIDE : SDFF_HEURISTIC_SQUARE, binWidth, binHeight);
+  case SDFF_PACKING_SKYLINE:
+    return new SDFF_SkylinePacker(binWidth, binHeight);
+  case SDFF_PACKING_DENSEST:
+    return new SDFF_DensestPacker(threadPool, binWidth, binHeight);
+  }
+
+  assert(0);
+  return NULL;
+}
+
+
+SDFF_Packer * SDFF_Packer::create(SDFF_PackingHeuristic heuristic, int binWidth, int binHeight)
+{
+  assert(heuristic >= SDFF_HEURISTIC_SQUARE && heuristic <= SDFF_HEURISTIC_CONTACT_POINT && binWidth > 0 && binHeight > 0);
+  return new SDFF_FreeRectsPacker(heuristic, binWidth, binHeight);
+}
+
+
+bool SDFF_Packer::insert(RectVector & rects, int &, int &)
+{
+  for (RectVector::iterator rectIt = rects.begin(); rectIt != rects.end(); ++rectIt)
+  {
+    rectIt->left = -1;
+    rectIt->top = -1;
+  }
+
+  return false;
+}
+
+
+// Every tie rule gives the smaller atlas on some rect sets, so an unbounded bin is packed with all of them and keeps
+// the smallest atlas, then the smallest bounds. The packer takes the state of the kept layout for the inserts to come.
+bool SDFF_FreeRectsPacker::pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom)
+{
+  if (binWidth_ < INT_MAX || binHeight_ < INT_MAX)
+  {
+    reset(rects, false);
+    return insert(rects, maxRight, maxBottom);
+  }
+
+  auto atlasArea = [powerOfTwo](int width, int height)
+  {
+    width = glm::max(width, 1);
+    height = glm::max(height, 1);
+    return powerOfTwo ? (double)roundUpToPowerOfTwo(width) * roundUpToPowerOfTwo(height) : (double)width * height;
+  };
+
+  RectVector bestRects;
+  double bestArea = DBL_MAX;
+  double bestBounds = DBL_MAX;
+
+  for (int tieRule = 0; tieRule < TIE_RULE_COUNT; tieRule++)
+  {
+    SDFF_FreeRectsPacker packer(heuristic_, binWidth_, binHeight_);
+    packer.tieRule_ = tieRule;
+    RectVector ruleRects = rects;
+    int right;
+    int bottom;
+    packer.reset(ruleRects, false);
+    packer.insert(ruleRects, right, bottom);
+    double area = atlasArea(right, bottom);
+    double bounds = (double)right * bottom;
+
+    if (area < bestArea || (area == bestArea && bounds < bestBounds))
+    {
+      bestArea = area;
+      bestBounds = bounds;
+      bestRects.swap(ruleRects);
+      *this = std::move(packer);
+    }
+  }
+
+  rects.swap(bestRects);
+  maxRight = maxRight_;
+  maxBottom = maxBottom_;
+
+  return true;
+}
+
+
+// an empty bin with the grid sized for the rects, the whole bin is covered when the rects to come are not known
+void SDFF_FreeRectsPacker::reset(const RectVector & rects, bool wholeBin)
+{
+  double area = 0.0;
+  int widest = 0;
+  int count = 0;
+
+  for (RectVector::const_iterator rectIt = rects.begin(); rectIt != rects.end(); ++rectIt)
+  {
+    area += (double)rectIt->width * rectIt->height;
+    widest = glm::max(widest, glm::max(rectIt->width, rectIt->height));
+    count += rectIt->width && rectIt->height;
+  }
+
+  // cells of about two average rects cover twice the expected atlas side or the bin, positions beyond it fall into the last cells
+  cellSize_ = glm::max(2 * (int)glm::sqrt(area / glm::max(count, 1)), 1);
+  double binSide = glm::max(binWidth_, binHeight_);
+  gridSize_ = glm::clamp((int)((wholeBin ? binSide : glm::min(2 * glm::sqrt(area) + widest, binSide)) / cellSize_) + 1, 1, 1024);
+  cells_.assign(gridSize_ * gridSize_, IdVector());
+  corners_.assign(gridSize_ * gridSize_, IdVector());
+  freeRects_.clear();
+  alive_.clear();
+  visits_.clear();
+  large_.clear();
+  placed_.clear();
+  placedVisits_.clear();
+  failed_.clear();
+  placedCells_.assign(heuristic_ == SDFF_HEURISTIC_CONTACT_POINT ? gridSize_ * gridSize_ : 0, IdVector());
+  visit_ = 0;
+
+  // statring with one free rect of the whole bin
+  Rect atlasRect = { 0, 0, binWidth_, binHeight_ };
+  add(atlasRect);
+  maxRight_ = 0;
+  maxBottom_ = 0;
+}
+
+
+bool SDFF_FreeRectsPacker::insert(RectVector & rects, int & maxRight, int & maxBottom)
+{
+  // the first insert into a bounded bin does not know how far the rects to come spread
+  if (freeRects_.empty())
+    reset(rects, binWidth_ < INT_MAX && binHeight_ < INT_MAX);
+
+  maxRight = maxRight_;
+  maxBottom = maxBottom_;
+  bool fits = true;
+
+  for (RectVector::iterator charRectIt = rects.begin(); charRectIt != rects.end(); ++charRectIt)
+  {
+    Rect & charRect = *charRectIt;
+
+    if (!charRect.width || !charRect.height)
+      continue;
+
+    bool failed = false;
+
+    for (int i = 0; i < (int)failed_.size() && !failed; i++)
+      failed = failed_[i].fitIn(charRect);
+
+    if (failed)
+    {
+      charRect.left = -1;
+      charRect.top = -1;
+      fits = false;
+      continue;
+    }
+
+    int bestId = -1;
+    double bestPrimary = DBL_MAX;
+    double bestSecondary = DBL_MAX;
+    double bestGrowth = DBL_MAX;
+    int bestMajor = INT_MAX;
+    int bestMinor = INT_MAX;
+
+    auto estimate = [&](int id)
+    {
+      const Rect & freeRect = freeRects_[id];
+
+      if (charRect.fitIn(freeRect))
+      {
+        double primary;
+        double secondary;
+        score(freeRect, charRect, maxRight, maxBottom, primary, secondary);
+
+        // equal scores take the position growing the bounds the least with that rule, so a tie never gives larger bounds
+        // than the other tied positions; the topmost or the leftmost one wins the rest, whatever order the rects are listed in
+        double growth = tieRule_ & TIE_GROWTH ? (double)glm::max(maxRight, freeRect.left + charRect.width) * glm::max(maxBottom, freeRect.top + charRect.height) : 0.0;
+        int major = tieRule_ & TIE_LEFT_TOP ? freeRect.left : freeRect.top;
+        int minor = tieRule_ & TIE_LEFT_TOP ? freeRect.top : freeRect.left;
+
+        if (primary < bestPrimary || (primary == bestPrimary && (secondary < bestSecondary || (secondary == bestSecondary &&
+          (growth < bestGrowth || (growth == bestGrowth && (major < bestMajor || (major == bestMajor && minor < bestMinor))))))))
+        {
+          bestPrimary = primary;
+          bestSecondary = secondary;
+          bestGrowth = growth;
+          bestMajor = major;
+          bestMinor = minor;
+          bestId = id;
+        }
+      }
+    };
+
+    auto estimateCorner = [&](IdVector & corner)
+    {
+      for (int i = 0; i < (int)corner.size();)
+      {
+        if (alive_[corner[i]])
+          estimate(corner[i++]);
+        else
+        {
+          corner[i] = corner.back();
+          corner.pop_back();
+        }
+      }
+    };
+
+    for (int i = 0; i < (int)large_.size(); i++)
+    {
+      if (alive_[large_[i]])
+        estimate(large_[i]);
+    }
+
+    if (heuristic_ == SDFF_HEURISTIC_SQUARE)
+    {
+      // corner cells by growing x + y of their corners, which bounds the estimator of their rects from below:
+      // the bounds take at least the half of the corner sum plus the char sides
+      for (int diagonal = 0; diagonal <= 2 * (gridSize_ - 1); diagonal++)
+      {
+        int minLeftTop = diagonal * cellSize_;
+        int minBounds = glm::max(glm::max(maxRight, maxBottom), (minLeftTop + charRect.width + charRect.height) / 2);
+
+        if (10.0f * minBounds + 0.1f * minLeftTop > bestPrimary)
+          break;
+
+        for (int x = glm::max(diagonal - gridSize_ + 1, 0); x <= glm::min(diagonal, gridSize_ - 1); x++)
+          estimateCorner(corners_[x + (diagonal - x) * gridSize_]);
+      }
+    }
+    else
+    {
+      // corner cells row by row, the bottom of the rects in a row is at least the row top plus the char height;
+      // the other heuristics do not depend on the position and visit all of them
+      for (int y = 0; y < gridSize_; y++)
+      {
+        if (heuristic_ == SDFF_HEURISTIC_BOTTOM_LEFT && (double)y * cellSize_ + charRect.height > bestPrimary)
+          break;
+
+        for (int x = 0; x < gridSize_; x++)
+          estimateCorner(corners_[x + y * gridSize_]);
+      }
+    }
+
+    // an unbounded bin always has a position
+    assert(bestId >= 0 || binWidth_ < INT_MAX || binHeight_ < INT_MAX);
+
+    if (bestId < 0)
+    {
+      // the sizes the new one implies are not needed any more
+      for (int i = 0; i < (int)failed_.size();)
+      {
+        if (charRect.fitIn(failed_[i]))
+        {
+          failed_[i] = failed_.back();
+          failed_.pop_back();
+        }
+        else
+          i++;
+      }
+
+      failed_.push_back(charRect);
+      charRect.left = -1;
+      charRect.top = -1;
+      fits = false;
+      continue;
+    }
+
+    // placing char into selected best free rect
+    charRect.left = freeRects_[bestId].left;
+    charRect.top = freeRects_[bestId].top;
+    maxRight = glm::max(maxRight, charRect.left + charRect.width);
+    maxBottom = glm::max(maxBottom, charRect.top + charRect.height);
+
+    if (!placedCells_.empty())
+    {
+      placed_.push_back(charRect);
+      placedVisits_.push_back(visit_);
+
+      for (int y = cell(charRect.top); y <= cell(charRect.bottom()); y++)
+      for (int x = cell(charRect.left); x <= cell(charRect.right()); x++)
+        placedCells_[x + y * gridSize_].push_back((int)placed_.size() - 1);
+    }
+
+    // every free rect intersecting the char is replaced by its parts left, above, right and below the char
+    splits_.clear();
+
+    query(charRect, [&](int id)
+    {
+      Rect freeRect = freeRects_[id];
+      alive_[id] = false;
+
+      if (charRect.left > freeRect.left)
+      {
+        Rect newRect = { freeRect.left, freeRect.top, charRect.left - freeRect.left, freeRect.height };
+        splits_.push_back(newRect);
+      }
+
+      if (charRect.top > freeRect.top)
+      {
+        Rect newRect = { freeRect.left, freeRect.top, freeRect.width, charRect.top - freeRect.top };
+        splits_.push_back(newRect);
+      }
+
+      if (charRect.right() < freeRect.right())
+      {
+        Rect newRect = { charRect.right() + 1, freeRect.top, freeRect.right() - charRect.right(), freeRect.height };
+        splits_.push_back(newRect);
+      }
+
+      if (charRect.bottom() < freeRect.bottom())
+      {
+        Rect newRect = { freeRect.left, charRect.bottom() + 1, freeRect.width, freeRect.bottom() - charRect.bottom() };
+        splits_.push_back(newRect);
+      }
+    });
+
+    // Containment pruning. Parts lie inside the replaced rects, so no free rect can be contained in a part,
+    // only parts can be contained in other parts or in the free rects left.
+    auto contains = [](const Rect & outer, const Rect & inner)
+    {
+      return inner.left >= outer.left && inner.top >= outer.top && inner.right() <= outer.right() && inner.bottom() <= outer.bottom();
+    };
+
+    for (int i = 0; i < (int)splits_.size(); i++)
+    {
+      bool contained = false;
+
+      for (int j = 0; j < (int)splits_.size() && !contained; j++)
+        contained = j != i && contains(splits_[j], splits_[i]) && (j < i || !(splits_[j] == splits_[i]));
+
+      // a rect containing a large part is large as well, so large parts are not looked up in the grid
+      if (!contained && large(splits_[i]))
+      {
+        for (int j = 0; j < (int)large_.size() && !contained; j++)
+          contained = alive_[large_[j]] && contains(freeRects_[large_[j]], splits_[i]);
+      }
+      else if (!contained)
+      {
+        query(splits_[i], [&](int id)
+        {
+          contained = contained || contains(freeRects_[id], splits_[i]);
+        });
+      }
+
+      if (!contained)
+        add(splits_[i]);
+    }
+  }
+
+  maxRight_ = maxRight;
+  maxBottom_ = maxBottom;
+  return fits;
+}
+
+
+void SDFF_FreeRectsPacker::add(const Rect & rect)
+{
+  int id = (int)freeRects_.size();
+  freeRects_.push_back(rect);
+  alive_.push_back(true);
+  visits_.push_back(visit_);
+
+  if (large(rect))
+  {
+    large_.push_back(id);
+    return;
+  }
+
+  for (int y = cell(rect.top); y <= cell(rect.bottom()); y++)
+  for (int x = cell(rect.left); x <= cell(rect.right()); x++)
+    cells_[x + y * gridSize_].push_back(id);
+
+  corners_[cell(rect.left) + cell(rect.top) * gridSize_].push_back(id);
+}
+
+
+// calls func once for every free rect intersecting the area, func may remove rects but not add them
+template <class Func>
+void SDFF_FreeRectsPacker::query(const Rect & area, Func func)
+{
+  visit_++;
+
+  // removed rects are dropped from the lists on the way
+  auto visit = [&](IdVector & ids)
+  {
+    for (int i = 0; i < (int)ids.size();)
+    {
+      int id = ids[i];
+
+      if (!alive_[id])
+      {
+        ids[i] = ids.back();
+        ids.pop_back();
+        continue;
+      }
+
+      if (visits_[id] != visit_)
+      {
+        visits_[id] = visit_;
+
+        if (freeRects_[id].intersect(area))
+          func(id);
+      }
+
+      i++;
+    }
+  };
+
+  visit(large_);
+
+  for (int y = cell(area.top); y <= cell(area.bottom()); y++)
+  for (int x = cell(area.left); x <= cell(area.right()); x++)
+    visit(cells_[x + y * gridSize_]);
+}
+
+
+// the score of the rect placed at the top left corner of the free rect
+void SDFF_FreeRectsPacker::score(const Rect & freeRect, const Rect & rect, int maxRight, int maxBottom, double & primary, double & secondary)
+{
+  int leftoverWidth = freeRect.width - rect.width;
+  int leftoverHeight = freeRect.height - rect.height;
+
+  switch (heuristic_)
+  {
+  case SDFF_HEURISTIC_SQUARE:
+  {
+    // the estimator prefers positions keeping the atlas square, then the ones closest to the top left corner
+    int minBounds = glm::max(glm::max(maxRight, freeRect.left + rect.width), glm::max(maxBottom, freeRect.top + rect.height));
+    int minLeftTop = freeRect.left + freeRect.top;
+    primary = 10.0f * minBounds + 0.1f * minLeftTop;
+    secondary = 0.0;
+    break;
+  }
+  case SDFF_HEURISTIC_BEST_SHORT_SIDE:
+    primary = glm::min(leftoverWidth, leftoverHeight);
+    secondary = glm::max(leftoverWidth, leftoverHeight);
+    break;
+  case SDFF_HEURISTIC_BEST_AREA:
+    primary = (double)freeRect.width * freeRect.height - (double)rect.width * rect.height;
+    secondary = glm::min(leftoverWidth, leftoverHeight);
+    break;
+  case SDFF_HEURISTIC_BOTTOM_LEFT:
+    primary = freeRect.top + rect.height;
+    secondary = freeRect.left;
+    break;
+  case SDFF_HEURISTIC_CONTACT_POINT:
+  {
+    Rect placedRect = { freeRect.left, freeRect.top, rect.width, rect.height };
+    primary = -contact(placedRect);
+    secondary = 0.0;
+    break;
+  }
+  }
+}
+
+
+// length of the rect perimeter touching the bin edges and the placed rects
+int SDFF_FreeRectsPacker::contact(const Rect & rect)
+{
+  int length = 0;
+
+  if (rect.left == 0 || rect.left + rect.width == binWidth_)
+    length += rect.height;
+
+  if (rect.top == 0 || rect.top + rect.height == binHeight_)
+    length += rect.width;
+
+  auto overlap = [](int first0, int last0, int first1, int last1) { return glm::max(glm::min(last0, last1) - glm::max(first0, first1) + 1, 0); };
+
+  // placed rects touching the rect are in the cells of the rect grown by one pixel
+  visit_++;
+
+  for (int y = cell(glm::max(rect.top - 1, 0)); y <= cell(rect.bottom() + 1); y++)
+  for (int x = cell(glm::max(rect.left - 1, 0)); x <= cell(rect.right() + 1); x++)
+  {
+    const IdVector & ids = placedCells_[x + y * gridSize_];
+
+    for (int i = 0; i < (int)ids.size(); i++)
+    {
+      if (placedVisits_[ids[i]] == visit_)
+        continue;
+
+      placedVisits_[ids[i]] = visit_;
+      const Rect & placedRect = placed_[ids[i]];
+
+      if (placedRect.right() + 1 == rect.left || placedRect.left == rect.right() + 1)
+        length += overlap(placedRect.top, placedRect.bottom(), rect.top, rect.bottom());
+
+      if (placedRect.bottom() + 1 == rect.top || placedRect.top == rect.bottom() + 1)
+        length += overlap(placedRect.left, placedRect.right(), rect.left, rect.right());
+    }
+  }
+
+  return length;
+}
+
+
+bool SDFF_SkylinePacker::pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom)
+{
+  reset(rects, powerOfTwo);
+  return insert(rects, maxRight, maxBottom);
+}
+
+
+void SDFF_SkylinePacker::reset(const RectVector & rects, bool powerOfTwo)
+{
+  double area = 0.0;
+  int widest = 0;
+
+  for (RectVector::const_iterator rectIt = rects.begin(); rectIt != rects.end(); ++rectIt)
+  {
+    area += (double)rectIt->width * rectIt->height;
+    widest = glm::max(widest, rectIt->width);
+  }
+
+  // the width is the side of the square of the rects area, the skyline grows down from it.
+  // The height of a power of two atlas is rounded up as well, so half of that area is enough to pick its width
+  atlasWidth_ = glm::max(widest, (int)glm::ceil(glm::sqrt(powerOfTwo ? area / 2 : area)));
+
+  if (powerOfTwo)
+    atlasWidth_ = roundUpToPowerOfTwo(atlasWidth_);
+
+  if (binWidth_ < INT_MAX)
+    atlasWidth_ = binWidth_;
+
+  Segment first = { 0, 0, atlasWidth_ };
+  skyline_.assign(1, first);
+  maxRight_ = 0;
+  maxBottom_ = 0;
+}
+
+
+bool SDFF_SkylinePacker::insert(RectVector & rects, int & maxRight, int & maxBottom)
+{
+  if (skyline_.empty())
+    reset(rects, false);
+
+  bool fits = true;
+
+  for (RectVector::iterator rectIt = rects.begin(); rectIt != rects.end(); ++rectIt)
+  {
+    Rect & rect = *rectIt;
+
+    if (!rect.width || !rect.height)
+      continue;
+
+    // bottom-left position, the atlas grows down, so the lowest bottom wins and the leftmost one of them
+    int bestIndex = -1;
+    int bestBottom = INT_MAX;
+
+    for (int index = 0; index < (int)skyline_.size(); index++)
+    {
+      int top = fit(index, rect.width);
+
+      if (top >= 0 && rect.height <= binHeight_ - top && top + rect.height < bestBottom)
+      {
+        bestIndex = index;
+        bestBottom = top + rect.height;
+      }
+    }
+
+    // an unbounded atlas as wide as the widest rect always has a position
+    if (bestIndex < 0)
+    {
+      rect.left = -1;
+      rect.top = -1;
+      fits = false;
+      continue;
+    }
+
+    rect.left = skyline_[bestIndex].left;
+    rect.top = bestBottom - rect.height;
+    place(bestIndex, rect);
+    maxRight_ = glm::max(maxRight_, rect.left + rect.width);
+    maxBottom_ = glm::max(maxBottom_, bestBottom);
+  }
+
+  maxRight = maxRight_;
+  maxBottom = maxBottom_;
+  return fits;
+}
+
+
+// top of a rect of the width placed at the left of the segment, -1 if it does not fit into the atlas
+int SDFF_SkylinePacker::fit(int index, int width) const
+{
+  if (skyline_[index].left + width > atlasWidth_)
+    return -1;
+
+  int top = 0;
+
+  for (int remaining = width; remaining > 0; index++)
+  {
+    top = glm::max(top, skyline_[index].top);
+    remaining -= skyline_[index].width;
+  }
+
+  return top;
+}
+
+
+// the rect bottom becomes a new segment, the segments it covers are cut and equal neighbors are merged
+void SDFF_SkylinePacker::place(int index, const Rect & rect)
+{
+  Segment segment = { rect.left, rect.top + rect.height, rect.width };
+  skyline_.insert(skyline_.begin() + index, segment);
+
+  for (int i = index + 1; i < (int)skyline_.size();)
+  {
+    int covered = skyline_[i - 1].left + skyline_[i - 1].width - skyline_[i].left;
+
+    if (covered <= 0)
+      break;
+
+    skyline_[i].left += covered;
+    skyline_[i].width -= covered;
+
+    if (skyline_[i].width > 0)
+      break;
+
+    skyline_.erase(skyline_.begin() + i);
+  }
+
+  for (int i = glm::max(index, 1); i < (int)skyline_.size() && i <= index + 1;)
+  {
+    if (skyline_[i - 1].top == skyline_[i].top)
+    {
+      skyline_[i - 1].width += skyline_[i].width;
+      skyline_.erase(skyline_.begin() + i);
+    }
+    else
+      i++;
+  }
+}
+
+
+bool SDFF_DensestPacker::pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom)
+{
+  double area = 0.0;
+  int widest = 1;
+  int tallest = 1;
+
+  for (RectVector::const_iterator rectIt = rects.begin(); rectIt != rects.end(); ++rectIt)
+  {
+    area += (double)rectIt->width * rectIt->height;
+    widest = glm::max(widest, rectIt->width);
+    tallest = glm::max(tallest, rectIt->height);
+  }
+
+  auto atlasArea = [powerOfTwo](const Layout & layout)
+  {
+    int width = glm::max(layout.maxRight, 1);
+    int height = glm::max(layout.maxBottom, 1);
+    return powerOfTwo ? (double)roundUpToPowerOfTwo(width) * roundUpToPowerOfTwo(height) : (double)width * height;
+  };
+
+  std::vector<IdVector> orders;
+  sortOrders(rects, orders);
+  std::vector<Layout> layouts;
+  Layout best;
+
+  if (binWidth_ < INT_MAX || binHeight_ < INT_MAX)
+  {
+    // every heuristic with every order and the skyline in the bin, the largest placed area wins and then the smallest atlas
+    Rect bin = { 0, 0, binWidth_, binHeight_ };
+    runHeuristics(rects, orders, bin, powerOfTwo, layouts);
+    layouts.push_back(Layout());
+    Layout & skyline = layouts.back();
+    skyline.rects = rects;
+    SDFF_SkylinePacker(binWidth_, binHeight_).pack(skyline.rects, powerOfTwo, skyline.maxRight, skyline.maxBottom);
+    skyline.fits = true;
+    double bestPlaced = -1.0;
+
+    for (int task = 0; task < (int)layouts.size(); task++)
+    {
+      double placed = 0.0;
+      layouts[task].fits = true;
+
+      for (RectVector::const_iterator rectIt = layouts[task].rects.begin(); rectIt != layouts[task].rects.end(); ++rectIt)
+      {
+        if (rectIt->left >= 0)
+          placed += (double)rectIt->width * rectIt->height;
+        else
+          layouts[task].fits = false;
+      }
+
+      if (placed > bestPlaced || (placed == bestPlaced && atlasArea(layouts[task]) < atlasArea(best)))
+      {
+        bestPlaced = placed;
+        best = layouts[task];
+      }
+    }
+
+    rects.swap(best.rects);
+    maxRight = best.maxRight;
+    maxBottom = best.maxBottom;
+    return best.fits;
+  }
+
+  // the free rects and the skyline packings of an unbounded atlas always fit, the smaller one is the atlas to beat
+  layouts.resize(2);
+  const float baselineCosts[] = { 1.0f, 0.1f };
+
+  run(2, baselineCosts, [&](int task, int)
+  {
+    Layout & layout = layouts[task];
+    layout.rects = rects;
+    std::unique_ptr<SDFF_Packer> packer(create(task ? SDFF_PACKING_SKYLINE : SDFF_PACKING_FREE_RECTS));
+    layout.fits = packer->pack(layout.rects, powerOfTwo, layout.maxRight, layout.maxBottom);
+  });
+
+  best = atlasArea(layouts[1]) < atlasArea(layouts[0]) ? layouts[1] : layouts[0];
+  double bestArea = atlasArea(best);
+
+  // bins smaller than that by increasing area: the power of two atlases holding the rects area,
+  // otherwise squares growing from the side of the rects area
+  RectVector bins;
+
+  if (powerOfTwo)
+  {
+    for (int width = roundUpToPowerOfTwo(widest); (double)width * roundUpToPowerOfTwo(tallest) < bestArea; width *= 2)
+    for (int height = roundUpToPowerOfTwo(tallest); (double)width * height < bestArea; height *= 2)
+    {
+      Rect bin = { 0, 0, width, height };
+
+      if ((double)width * height >= area)
+        bins.push_back(bin);
+    }
+
+    // the squarest bin of an area first
+    std::stable_sort(bins.begin(), bins.end(), [](const Rect & a, const Rect & b)
+    {
+      double areaA = (double)a.width * a.height;
+      double areaB = (double)b.width * b.height;
+      return areaA < areaB || (areaA == areaB && glm::abs(a.width - a.height) < glm::abs(b.width - b.height));
+    });
+  }
+  else
+  {
+    for (int step = 0; ; step++)
+    {
+      int side = (int)glm::ceil(glm::sqrt(area) * (1.0 + 0.02 * step));
+      Rect bin = { 0, 0, glm::max(side, widest), glm::max(side, tallest) };
+
+      if ((double)bin.width * bin.height >= bestArea)
+        break;
+
+      bins.push_back(bin);
+    }
+  }
+
+  // the first bin some of the heuristics fit into is the smallest one
+  for (int binIndex = 0; binIndex < (int)bins.size(); binIndex++)
+  {
+    runHeuristics(rects, orders, bins[binIndex], powerOfTwo, layouts);
+
+    // the smallest atlas in the bin, the first task of equal ones
+    int bestTask = -1;
+
+    for (int task = 0; task < (int)layouts.size(); task++)
+    {
+      if (layouts[task].fits && (bestTask < 0 || atlasArea(layouts[task]) < atlasArea(layouts[bestTask])))
+        bestTask = task;
+    }
+
+    if (bestTask >= 0)
+    {
+      if (atlasArea(layouts[bestTask]) < bestArea)
+        best = layouts[bestTask];
+
+      break;
+    }
+  }
+
+  rects.swap(best.rects);
+  maxRight = best.maxRight;
+  maxBottom = best.maxBottom;
+  return true;
+}
+
+
+bool SDFF_DensestPacker::insert(RectVector & rects, int & maxRight, int & maxBottom)
+{
+  if (filled_)
+    return SDFF_Packer::insert(rects, maxRight, maxBottom);
+
+  filled_ = true;
+  return pack(rects, false, maxRight, maxBottom);
+}
+
+
+void SDFF_DensestPacker::run(int count, const float * costs, const SDFF_ThreadPool::TaskFunc & func)
+{
+  // the stats of the pool report the balance of glyph building, packing stays out of them
+  if (threadPool_)
+    threadPool_->runTasks(count, costs, func, false);
+  else
+  {
+    for (int task = 0; task < count; task++)
+      func(task, 0);
+  }
+}
+
+
+// ids of the rects by decreasing area, perimeter, longest side, height and width, the given order breaks ties
+void SDFF_DensestPacker::sortOrders(const RectVector & rects, std::vector<IdVector> & orders) const
+{
+  orders.assign(orderCount, IdVector(rects.size()));
+
+  for (int order = 0; order < orderCount; order++)
+  {
+    IdVector & ids = orders[order];
+
+    for (int i = 0; i < (int)ids.size(); i++)
+      ids[i] = i;
+
+    auto key = [&](int id)
+    {
+      const Rect & rect = rects[id];
+
+      switch (order)
+      {
+      case 0:
+        return (double)rect.width * rect.height;
+      case 1:
+        return (double)rect.width + rect.height;
+      case 2:
+        return (double)glm::max(rect.width, rect.height);
+      case 3:
+        return (double)rect.height;
+      default:
+        return (double)rect.width;
+      }
+    };
+
+    std::stable_sort(ids.begin(), ids.end(), [&](int a, int b) { return key(a) > key(b); });
+  }
+}
+
+
+// every heuristic but the square one with every order in the bin, a layout per run in the given rects order
+void SDFF_DensestPacker::runHeuristics(const RectVector & rects, const std::vector<IdVector> & orders, const Rect & bin, bool powerOfTwo, std::vector<Layout> & layouts)
+{
+  const int heuristicCount = SDFF_HEURISTIC_CONTACT_POINT - SDFF_HEURISTIC_BEST_SHORT_SIDE + 1;
+  const float heuristicCosts[heuristicCount] = { 2.0f, 2.0f, 1.0f, 3.0f };
+  std::vector<float> costs(heuristicCount * orderCount);
+
+  for (int task = 0; task < (int)costs.size(); task++)
+    costs[task] = heuristicCosts[task / orderCount];
+
+  layouts.resize(costs.size());
+
+  run((int)costs.size(), costs.data(), [&](int task, int)
+  {
+    Layout & layout = layouts[task];
+    const IdVector & ids = orders[task % orderCount];
+    SDFF_FreeRectsPacker packer((SDFF_PackingHeuristic)(SDFF_HEURISTIC_BEST_SHORT_SIDE + task / orderCount), bin.width, bin.height);
+    RectVector sortedRects(ids.size());
+
+    for (int i = 0; i < (int)ids.size(); i++)
+      sortedRects[i] = rects[ids[i]];
+
+    layout.fits = packer.pack(sortedRects, powerOfTwo, layout.maxRight, layout.maxBottom);
+    layout.rects.resize(ids.size());
+
+    for (int i = 0; i < (int)ids.size(); i++)
+      layout.rects[ids[i]] = sortedRects[i];
+  });
+}
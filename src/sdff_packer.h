@@ -0,0 +1,74 @@
+#pragma once
+
+// How glyph bitmaps are placed into the atlas
+enum SDFF_Packing
+{
+  // best position among the maximal free rectangles, which keeps the atlas square;
+  // a glyph visits the free rectangles of a few grid cells and the ones around the packed area.
+  // The atlas is packed once per rule settling equal positions and the smallest one is kept.
+  // A bounded page takes the best short side fit instead, which keeps large free rectangles for the glyphs to come
+  SDFF_PACKING_FREE_RECTS = 0,
+  // bottom-left position on the skyline of an atlas of fixed width, a glyph visits only the skyline segments,
+  // much faster for large glyph sets at the price of the space left under the skyline
+  SDFF_PACKING_SKYLINE,
+  // the smallest atlas of several free rectangle heuristics and sort orders run on the builder threads
+  // in bins smaller than the atlas of the two packings above, never larger than the smaller of them;
+  // a bounded page gets the layout placing the largest glyph area
+  SDFF_PACKING_DENSEST
+};
+
+// How a free rectangle packer scores the positions of a rect, the lowest score wins
+enum SDFF_PackingHeuristic
+{
+  // the free rectangles packing estimator, keeps the bounds of the placed rects square and then the position close to the corner
+  SDFF_HEURISTIC_SQUARE = 0,
+  // the free rectangle leaving the shortest side, then the longest one
+  SDFF_HEURISTIC_BEST_SHORT_SIDE,
+  // the smallest free rectangle, then the shortest side left
+  SDFF_HEURISTIC_BEST_AREA,
+  // the topmost bottom edge, then the leftmost position
+  SDFF_HEURISTIC_BOTTOM_LEFT,
+  // the longest perimeter touching the bin edges and the placed rects
+  SDFF_HEURISTIC_CONTACT_POINT
+};
+
+class SDFF_ThreadPool;
+
+// Places rectangles into the atlas, the interface every packing strategy implements
+class SDFF_Packer
+{
+public:
+  struct Rect
+  {
+    int left;
+    int top;
+    int width;
+    int height;
+
+    int bottom() const { return top + height - 1; }
+    int right() const { return left + width - 1; }
+    bool intersect(const Rect & rect) const { return rect.left < left + width && rect.left + rect.width > left && rect.top < top + height && rect.top + rect.height > top; }
+    bool contain(int x, int y) const { return x >= left && x < left + width && y >= top && y < top + height; }
+    bool fitIn(const Rect & rect) const { return rect.width >= width && rect.height >= height; }
+    bool operator ==(const Rect & rect) const { return rect.left == left && rect.top == top && rect.width == width && rect.height == height; }
+  };
+
+  typedef std::vector<Rect> RectVector;
+
+  // the thread pool runs the heuristics of the densest packing, which are run one by one without it;
+  // INT_MAX bin sides make the bin unbounded
+  static SDFF_Packer * create(SDFF_Packing packing, SDFF_ThreadPool * threadPool = NULL, int binWidth = INT_MAX, int binHeight = INT_MAX);
+  // free rectangles packer of a bin, INT_MAX sides make it unbounded
+  static SDFF_Packer * create(SDFF_PackingHeuristic heuristic, int binWidth = INT_MAX, int binHeight = INT_MAX);
+
+  virtual ~SDFF_Packer() {}
+
+  // Sets the position of every rect, in the given order, which is best by decreasing area; empty rects stay where they are.
+  // maxRight and maxBottom are the bounds of the placed rects, powerOfTwo tells the atlas size is rounded up later.
+  // Rects not fitting into a bounded bin get -1 position and the result is false.
+  virtual bool pack(RectVector & rects, bool powerOfTwo, int & maxRight, int & maxBottom) = 0;
+  // Places the rects into the space left by the previous inserts without moving the rects placed before,
+  // the first insert starts with an empty bin and pack starts over. The free rectangles and the skyline packers keep that state,
+  // the densest packer fills the bin with its first insert and places nothing after it.
+  virtual bool insert(RectVector & rects, int & maxRight, int & maxBottom);
+};
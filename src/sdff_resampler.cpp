@@ -0,0 +1,261 @@
+#include "static_headers.h"
+
+#include "sdff_resampler.h"
+
+SDFF_Resampler::SDFF_Resampler()
+{
+  filter_ = SDFF_FILTER_BOX;
+  srcSize_ = 0;
+  destSize_ = 0;
+  taps_ = 0;
+}
+
+
+void SDFF_Resampler::init(int srcSize, int destSize, SDFF_Filter filter)
+{
+  assert(srcSize > 0);
+  assert(destSize > 0);
+  filter_ = filter;
+  srcSize_ = srcSize;
+  destSize_ = destSize;
+  destBegins_.assign(srcSize, destSize);
+  destEnds_.assign(srcSize, 0);
+
+  if (filter == SDFF_FILTER_BOX)
+    initBox();
+  else
+    initKernel(filter);
+}
+
+
+void SDFF_Resampler::initBox()
+{
+  float scale = float(destSize_) / srcSize_;
+  float opScale = 1.0f / scale;
+
+  // the source pixel [x, x + 1) covers dest texels from destLeft to destRight, a pixel reaching past
+  // the last texel gives all of itself to the one it starts in
+  std::vector<int> firsts(destSize_, srcSize_);
+  std::vector<int> lasts(destSize_, -1);
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int x = 0; x < srcSize_; x++)
+    {
+      float destLeftf = x * scale;
+      float destRightf = (x + 1) * scale;
+      int destLefti = (int)destLeftf;
+      int destRighti = (int)destRightf;
+      bool single = destLefti == destRighti || destRighti >= destSize_;
+
+      if (pass == 0)
+      {
+        firsts[destLefti] = glm::min(firsts[destLefti], x);
+        lasts[destLefti] = x;
+        destBegins_[x] = destLefti;
+        destEnds_[x] = destLefti + 1;
+
+        if (!single)
+        {
+          firsts[destRighti] = glm::min(firsts[destRighti], x);
+          lasts[destRighti] = x;
+          destEnds_[x] = destRighti + 1;
+        }
+      }
+      else if (single)
+        weights_[destLefti * taps_ + x - starts_[destLefti]] = 1.0f;
+      else
+      {
+        weights_[destLefti * taps_ + x - starts_[destLefti]] = (destRighti - destLeftf) * opScale;
+        weights_[destRighti * taps_ + x - starts_[destRighti]] = (destRightf - destRighti) * opScale;
+      }
+    }
+
+    if (pass == 0)
+      setWindows(firsts, lasts);
+  }
+}
+
+
+void SDFF_Resampler::initKernel(SDFF_Filter filter)
+{
+  // the kernel is stretched by the number of source pixels per texel and sampled at source pixel centers,
+  // pixels past the source edges are replaced with the edge ones
+  float opScale = float(srcSize_) / destSize_;
+  float stretch = glm::max(opScale, 1.0f);
+  float radius = kernelRadius(filter) * stretch;
+  std::vector<int> firsts(destSize_);
+  std::vector<int> lasts(destSize_);
+
+  for (int i = 0; i < destSize_; i++)
+  {
+    float center = (i + 0.5f) * opScale;
+    firsts[i] = glm::max((int)glm::ceil(center - radius - 0.5f), 0);
+    lasts[i] = glm::min((int)glm::floor(center + radius - 0.5f), srcSize_ - 1);
+    lasts[i] = glm::max(lasts[i], firsts[i]);
+
+    for (int x = firsts[i]; x <= lasts[i]; x++)
+    {
+      destBegins_[x] = glm::min(destBegins_[x], i);
+      destEnds_[x] = glm::max(destEnds_[x], i + 1);
+    }
+  }
+
+  setWindows(firsts, lasts);
+
+  for (int i = 0; i < destSize_; i++)
+  {
+    float center = (i + 0.5f) * opScale;
+    float * texelWeights = &weights_[i * taps_];
+    int first = (int)glm::ceil(center - radius - 0.5f);
+    int last = (int)glm::floor(center + radius - 0.5f);
+    float sum = 0.0f;
+
+    for (int x = first; x <= last; x++)
+    {
+      float w = kernel(filter, (x + 0.5f - center) / stretch);
+      int clampedX = glm::clamp(x, 0, srcSize_ - 1);
+      texelWeights[clampedX - starts_[i]] += w;
+      sum += w;
+    }
+
+    for (int k = 0; k < taps_ && sum != 0.0f; k++)
+      texelWeights[k] *= opScale / sum;
+  }
+}
+
+
+void SDFF_Resampler::setWindows(const std::vector<int> & firsts, const std::vector<int> & lasts)
+{
+  span_ = 1;
+
+  for (int i = 0; i < destSize_; i++)
+    span_ = glm::max(span_, lasts[i] - firsts[i] + 1);
+
+  taps_ = span_;
+
+  // SIMD kernels take taps by 8, windows are shifted left to stay inside of the source
+  if ((taps_ + 7) / 8 * 8 <= srcSize_)
+    taps_ = (taps_ + 7) / 8 * 8;
+
+  starts_.resize(destSize_);
+
+  for (int i = 0; i < destSize_; i++)
+    starts_[i] = glm::max(glm::min(firsts[i], srcSize_ - taps_), 0);
+
+  weights_.assign(destSize_ * taps_, 0.0f);
+}
+
+
+float SDFF_Resampler::kernelRadius(SDFF_Filter filter)
+{
+  switch (filter)
+  {
+  case SDFF_FILTER_TENT:
+    return 1.0f;
+  case SDFF_FILTER_MITCHELL:
+    return 2.0f;
+  case SDFF_FILTER_LANCZOS3:
+    return 3.0f;
+  default:
+    return 0.5f;
+  }
+}
+
+
+float SDFF_Resampler::kernel(SDFF_Filter filter, float x)
+{
+  x = glm::abs(x);
+
+  switch (filter)
+  {
+  case SDFF_FILTER_TENT:
+    return glm::max(1.0f - x, 0.0f);
+
+  case SDFF_FILTER_MITCHELL:
+  {
+    const float b = 1.0f / 3.0f;
+    const float c = 1.0f / 3.0f;
+
+    if (x < 1.0f)
+      return ((12 - 9 * b - 6 * c) * x * x * x + (-18 + 12 * b + 6 * c) * x * x + (6 - 2 * b)) / 6;
+    else if (x < 2.0f)
+      return ((-b - 6 * c) * x * x * x + (6 * b + 30 * c) * x * x + (-12 * b - 48 * c) * x + (8 * b + 24 * c)) / 6;
+    else
+      return 0.0f;
+  }
+
+  case SDFF_FILTER_LANCZOS3:
+  {
+    const float pi = 3.14159265f;
+
+    if (x < 1e-5f)
+      return 1.0f;
+    else if (x < 3.0f)
+      return 3 * glm::sin(pi * x) * glm::sin(pi * x / 3) / (pi * pi * x * x);
+    else
+      return 0.0f;
+  }
+
+  default:
+    return x <= 0.5f ? 1.0f : 0.0f;
+  }
+}
+
+
+float SDFF_Resampler::weight(int dest, int src) const
+{
+  int tap = src - starts_[dest];
+  return tap >= 0 && tap < taps_ ? weights_[dest * taps_ + tap] : 0.0f;
+}
+
+
+void SDFF_Resampler::resample(SDFF_SimdLevel simdLevel, const float * src, float * dest) const
+{
+  SDFF_Simd::gatherRow(simdLevel, src, starts_.data(), weights_.data(), taps_, dest, destSize_);
+}
+
+
+void SDFF_Resampler::accumulate(const float * src, float weight, float * dest) const
+{
+  int i = 0;
+
+  // four texels at once, their sums are independent so the additions of one do not wait for the other ones
+  for (; i + 4 <= destSize_; i += 4)
+  {
+    const float * texelWeights = &weights_[i * taps_];
+    const float * srcTaps0 = src + starts_[i];
+    const float * srcTaps1 = src + starts_[i + 1];
+    const float * srcTaps2 = src + starts_[i + 2];
+    const float * srcTaps3 = src + starts_[i + 3];
+    float sum0 = dest[i];
+    float sum1 = dest[i + 1];
+    float sum2 = dest[i + 2];
+    float sum3 = dest[i + 3];
+
+    for (int k = 0; k < taps_; k++)
+    {
+      sum0 += texelWeights[k] * weight * srcTaps0[k];
+      sum1 += texelWeights[taps_ + k] * weight * srcTaps1[k];
+      sum2 += texelWeights[2 * taps_ + k] * weight * srcTaps2[k];
+      sum3 += texelWeights[3 * taps_ + k] * weight * srcTaps3[k];
+    }
+
+    dest[i] = sum0;
+    dest[i + 1] = sum1;
+    dest[i + 2] = sum2;
+    dest[i + 3] = sum3;
+  }
+
+  for (; i < destSize_; i++)
+  {
+    const float * texelWeights = &weights_[i * taps_];
+    const float * srcTaps = src + starts_[i];
+    float sum = dest[i];
+
+    for (int k = 0; k < taps_; k++)
+      sum += texelWeights[k] * weight * srcTaps[k];
+
+    dest[i] = sum;
+  }
+}
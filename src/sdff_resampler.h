@@ -0,0 +1,68 @@
+#pragma once
+
+#include "sdff_simd.h"
+
+// Reconstruction filter of the downsampling from the source resolution to the distance field texels
+enum SDFF_Filter
+{
+  // area-weighted average of the source pixels under the texel
+  SDFF_FILTER_BOX = 0,
+  // linear falloff over two texels
+  SDFF_FILTER_TENT,
+  // Mitchell-Netravali cubic (B = C = 1/3) over four texels
+  SDFF_FILTER_MITCHELL,
+  // windowed sinc over six texels, the sharpest one
+  SDFF_FILTER_LANCZOS3
+};
+
+// Weight table of downsampling along one axis. Every dest texel gathers a window of taps source pixels
+// starting at its own first pixel, so rows are resampled by a SIMD gather instead of a scatter of source pixels.
+// A 2D field is filtered separably: rows are gathered horizontally, then added into the dest rows
+// their source row contributes to with the weights of the vertical table.
+// Weights of a texel sum to the number of source pixels per texel, the same scale for all filters.
+// The box filter adds the weighted pixels one by one instead, in the order of the former scatter of source pixels.
+class SDFF_Resampler
+{
+public:
+  SDFF_Resampler();
+
+  void init(int srcSize, int destSize, SDFF_Filter filter = SDFF_FILTER_BOX);
+  // filter weights are never negative, so the result stays within the source value range
+  static bool isPositive(SDFF_Filter filter) { return filter == SDFF_FILTER_BOX || filter == SDFF_FILTER_TENT; }
+
+  SDFF_Filter filter() const { return filter_; }
+  int srcSize() const { return srcSize_; }
+  int destSize() const { return destSize_; }
+  // widest span of source pixels with nonzero weights of one texel
+  int span() const { return span_; }
+  // first source pixel of the dest texel window and the pixel after its end
+  int srcBegin(int dest) const { return starts_[dest]; }
+  int srcEnd(int dest) const { return starts_[dest] + taps_; }
+  // dest texels the source pixel contributes to are in [destBegin, destEnd)
+  int destBegin(int src) const { return destBegins_[src]; }
+  int destEnd(int src) const { return destEnds_[src]; }
+  float weight(int dest, int src) const;
+
+  // horizontal pass, src holds srcSize values and dest receives destSize ones
+  void resample(SDFF_SimdLevel simdLevel, const float * src, float * dest) const;
+  // adds the source row scaled by the weight into dest, every texel sums its taps in source pixel order;
+  // with the box filter that is the summation order of a scatter of the source pixels, so the output does not change
+  void accumulate(const float * src, float weight, float * dest) const;
+
+private:
+  SDFF_Filter filter_;
+  int srcSize_;
+  int destSize_;
+  int span_;
+  int taps_;
+  std::vector<int> starts_;
+  std::vector<float> weights_;
+  std::vector<int> destBegins_;
+  std::vector<int> destEnds_;
+
+  void initBox();
+  void initKernel(SDFF_Filter filter);
+  void setWindows(const std::vector<int> & firsts, const std::vector<int> & lasts);
+  static float kernelRadius(SDFF_Filter filter);
+  static float kernel(SDFF_Filter filter, float x);
+};
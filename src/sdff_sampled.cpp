@@ -0,0 +1,179 @@
+#include "static_headers.h"
+
+#include "sdff_sampled.h"
+
+SDFF_SampledSdf::SDFF_SampledSdf()
+{
+  width_ = 0;
+  height_ = 0;
+  maxDistance_ = 0;
+}
+
+
+void SDFF_SampledSdf::init(const FT_Bitmap & bitmap, int falloff, int maxDistance)
+{
+  assert(falloff >= 0);
+  assert(maxDistance > 0);
+  width_ = bitmap.width + 2 * falloff;
+  height_ = bitmap.rows + 2 * falloff;
+  maxDistance_ = maxDistance;
+  int pitchBytes = (bitmap.width + 7) / 8;
+
+  // a switch is where a bitmap row differs from the one above, the row below the bitmap is background;
+  // the first pass counts switches per column, the second one stores their rows
+  columnStarts_.assign(width_ + 1, 0);
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    std::vector<int> columnEnds;
+
+    if (pass == 1)
+    {
+      for (int x = 0; x < width_; x++)
+        columnStarts_[x + 1] += columnStarts_[x];
+
+      switches_.resize(columnStarts_[width_]);
+      columnEnds.assign(columnStarts_.begin(), columnStarts_.end() - 1);
+    }
+
+    for (int y = 0; y <= (int)bitmap.rows; y++)
+    {
+      const unsigned char * row = y < (int)bitmap.rows ? bitmap.buffer + y * bitmap.pitch : NULL;
+      const unsigned char * prevRow = y > 0 ? bitmap.buffer + (y - 1) * bitmap.pitch : NULL;
+
+      for (int byteIndex = 0; byteIndex < pitchBytes; byteIndex++)
+      {
+        int diff = (row ? row[byteIndex] : 0) ^ (prevRow ? prevRow[byteIndex] : 0);
+
+        for (int bit = 0; diff && bit < 8; bit++)
+        {
+          int x = falloff + byteIndex * 8 + bit;
+
+          if (!(diff & (0x80 >> bit)) || x >= falloff + (int)bitmap.width)
+            continue;
+
+          if (pass == 0)
+            columnStarts_[x + 1]++;
+          else
+            switches_[columnEnds[x]++] = falloff + y;
+        }
+      }
+    }
+  }
+}
+
+
+void SDFF_SampledSdf::createSdf(int destWidth, int destHeight, int samples, int firstRow, int lastRow, float * result) const
+{
+  assert(samples > 0);
+  float horzOpScale = float(width_) / destWidth;
+  float vertOpScale = float(height_) / destHeight;
+  float sampleWeight = 1.0f / (samples * samples);
+  const int band = maxDistance_;
+  const int bandSq = band * band;
+
+  // g holds outer column distances followed by inner ones, s and t are the lower envelope
+  std::vector<int> g(2 * width_);
+  std::vector<int> envelopes(2 * width_);
+  std::vector<int> sampleXs(destWidth * samples);
+  int * s = envelopes.data();
+  int * t = s + width_;
+
+  for (int i = 0; i < destWidth * samples; i++)
+    sampleXs[i] = glm::min((int)((i / samples + (i % samples + 0.5f) / samples) * horzOpScale), width_ - 1);
+
+  for (int destY = firstRow; destY < lastRow; destY++)
+  {
+    float * resultRow = result + destY * destWidth;
+
+    for (int x = 0; x < destWidth; x++)
+      resultRow[x] = 0.0f;
+
+    for (int j = 0; j < samples; j++)
+    {
+      int y = glm::min((int)((destY + (j + 0.5f) / samples) * vertOpScale), height_ - 1);
+
+      for (int x = 0; x < width_; x++)
+        columnDistances(x, y, g[x], g[x + width_]);
+
+      for (int inner = 0; inner < 2; inner++)
+      {
+        const int * gSide = g.data() + inner * width_;
+        int q = -1;
+
+        // Scan 3 of the row stage, columns beyond the band can not bring a distance under it
+        for (int x = 0; x < width_; x++)
+        {
+          if (gSide[x] >= band)
+            continue;
+
+          if (q < 0)
+          {
+            q = 0;
+            s[0] = x;
+            t[0] = 0;
+            continue;
+          }
+
+          while (q >= 0 && (t[q] - s[q]) * (t[q] - s[q]) + gSide[s[q]] * gSide[s[q]] > (t[q] - x) * (t[q] - x) + gSide[x] * gSide[x])
+            q--;
+
+          if (q < 0)
+          {
+            q = 0;
+            s[0] = x;
+          }
+          else
+          {
+            int w = 1 + (x * x - s[q] * s[q] + gSide[x] * gSide[x] - gSide[s[q]] * gSide[s[q]]) / (2 * (x - s[q]));
+
+            if (w < width_)
+            {
+              q++;
+              s[q] = x;
+              t[q] = w;
+            }
+          }
+        }
+
+        // samples are in increasing order, so the envelope segment only moves forward;
+        // ink samples take the inner distance, background ones the outer distance
+        int segment = 0;
+
+        for (int i = 0; i < destWidth * samples; i++)
+        {
+          int x = sampleXs[i];
+
+          if ((g[x] == 0) != (inner != 0))
+            continue;
+
+          while (segment < q && t[segment + 1] <= x)
+            segment++;
+
+          int distanceSq = q < 0 ? bandSq : (x - s[segment]) * (x - s[segment]) + gSide[s[segment]] * gSide[s[segment]];
+          float distance = distanceSq < bandSq ? std::sqrtf((float)distanceSq) : (float)band;
+          resultRow[i / samples] += (inner ? 1.0f - distance : distance) * sampleWeight;
+        }
+      }
+    }
+  }
+}
+
+
+// distances along the column from row y to the nearest ink and background pixels, a large value if there is none
+void SDFF_SampledSdf::columnDistances(int x, int y, int & outer, int & inner) const
+{
+  const int * begin = switches_.data() + columnStarts_[x];
+  const int * end = switches_.data() + columnStarts_[x + 1];
+  const int * next = std::upper_bound(begin, end, y);
+
+  // a run of the other kind starts at the next switch, the previous switch ends the run above
+  int distance = next != end ? *next - y : maxDistance_;
+
+  if (next != begin)
+    distance = glm::min(distance, y - next[-1] + 1);
+
+  bool ink = ((next - begin) & 1) != 0;
+  outer = ink ? 0 : distance;
+  inner = ink ? distance : 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Signed distances of the mono bitmap evaluated only at the samples of the dest texels.
+// Every column of the padded bitmap is kept as a sorted list of rows where it switches between
+// background and ink, so column distances of any row come from a binary search per column, and the
+// Meijster row stage runs only for the rows holding samples. Values match the full transform at the
+// sampled pixels, while the work is linear in the source width times the sample rows, not in the source area.
+class SDFF_SampledSdf
+{
+public:
+  SDFF_SampledSdf();
+
+  // bitmap is padded by falloff on each side, distances are clamped to maxDistance
+  void init(const FT_Bitmap & bitmap, int falloff, int maxDistance);
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // Rows [firstRow, lastRow) of the dest texel grid covering the padded bitmap,
+  // every texel is the average of samples x samples pixel distances evenly spread over it.
+  // Distances are positive outside of the glyph, safe to call from several threads.
+  void createSdf(int destWidth, int destHeight, int samples, int firstRow, int lastRow, float * result) const;
+
+private:
+  int width_;
+  int height_;
+  int maxDistance_;
+  // switch rows of the column x are in [columnStarts_[x], columnStarts_[x + 1]), the column starts with background
+  std::vector<int> columnStarts_;
+  std::vector<int> switches_;
+
+  void columnDistances(int x, int y, int & outer, int & inner) const;
+};
@@ -0,0 +1,459 @@
+#include "static_headers.h"
+
+#include "sdff_simd.h"
+
+#ifdef SDFF_SIMD_X86
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SDFF_TARGET_SSE41
+#define SDFF_TARGET_AVX2
+#else
+#define SDFF_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SDFF_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif
+
+SDFF_SimdLevel SDFF_Simd::detectLevel()
+{
+#if defined(SDFF_SIMD_X86) && defined(_MSC_VER)
+
+  int info[4];
+  __cpuid(info, 0);
+  int maxLeaf = info[0];
+  __cpuid(info, 1);
+  bool sse41 = (info[2] & (1 << 19)) != 0;
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  bool avx2 = false;
+
+  // AVX state must be enabled by OS as well
+  if (osxsave && avx && (_xgetbv(0) & 6) == 6 && maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+
+  if (avx2)
+    return SDFF_SIMD_AVX2;
+  else if (sse41)
+    return SDFF_SIMD_SSE41;
+  else
+    return SDFF_SIMD_SCALAR;
+
+#elif defined(SDFF_SIMD_X86)
+
+  if (__builtin_cpu_supports("avx2"))
+    return SDFF_SIMD_AVX2;
+  else if (__builtin_cpu_supports("sse4.1"))
+    return SDFF_SIMD_SSE41;
+  else
+    return SDFF_SIMD_SCALAR;
+
+#else
+
+  return SDFF_SIMD_SCALAR;
+
+#endif
+}
+
+
+void SDFF_Simd::unpackBits(SDFF_SimdLevel level, const unsigned char * bits, unsigned char * pixels, int count)
+{
+#ifdef SDFF_SIMD_X86
+  if (level == SDFF_SIMD_AVX2)
+    unpackBitsAvx2(bits, pixels, count);
+  else if (level == SDFF_SIMD_SSE41)
+    unpackBitsSse41(bits, pixels, count);
+  else
+#endif
+    unpackBitsScalar(bits, pixels, count, 0);
+}
+
+
+void SDFF_Simd::edtScanDown(SDFF_SimdLevel level, const unsigned char * ink, const int * prevRow, int * row, int width)
+{
+#ifdef SDFF_SIMD_X86
+  if (level == SDFF_SIMD_AVX2)
+    edtScanDownAvx2(ink, prevRow, row, width);
+  else if (level == SDFF_SIMD_SSE41)
+    edtScanDownSse41(ink, prevRow, row, width);
+  else
+#endif
+    edtScanDownScalar(ink, prevRow, row, width, 0);
+}
+
+
+void SDFF_Simd::edtScanUp(SDFF_SimdLevel level, const int * nextRow, int * row, int count)
+{
+#ifdef SDFF_SIMD_X86
+  if (level == SDFF_SIMD_AVX2)
+    edtScanUpAvx2(nextRow, row, count);
+  else if (level == SDFF_SIMD_SSE41)
+    edtScanUpSse41(nextRow, row, count);
+  else
+#endif
+    edtScanUpScalar(nextRow, row, count, 0);
+}
+
+
+void SDFF_Simd::edtDistances(SDFF_SimdLevel level, const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width)
+{
+#ifdef SDFF_SIMD_X86
+  if (level == SDFF_SIMD_AVX2)
+    edtDistancesAvx2(gRow, distancesSq, bandSq, distances, width);
+  else if (level == SDFF_SIMD_SSE41)
+    edtDistancesSse41(gRow, distancesSq, bandSq, distances, width);
+  else
+#endif
+    edtDistancesScalar(gRow, distancesSq, bandSq, distances, width, 0);
+}
+
+
+void SDFF_Simd::gatherRow(SDFF_SimdLevel level, const float * src, const int * starts, const float * weights, int taps, float * dest, int count)
+{
+#ifdef SDFF_SIMD_X86
+  if (taps % 8 == 0 && level == SDFF_SIMD_AVX2)
+    gatherRowAvx2(src, starts, weights, taps, dest, count);
+  else if (taps % 8 == 0 && level == SDFF_SIMD_SSE41)
+    gatherRowSse41(src, starts, weights, taps, dest, count);
+  else
+#endif
+    gatherRowScalar(src, starts, weights, taps, dest, count);
+}
+
+
+void SDFF_Simd::accumulateRow(SDFF_SimdLevel level, float weight, const float * src, float * dest, int count)
+{
+#ifdef SDFF_SIMD_X86
+  if (level == SDFF_SIMD_AVX2)
+    accumulateRowAvx2(weight, src, dest, count);
+  else if (level == SDFF_SIMD_SSE41)
+    accumulateRowSse41(weight, src, dest, count);
+  else
+#endif
+    accumulateRowScalar(weight, src, dest, count, 0);
+}
+
+
+void SDFF_Simd::unpackBitsScalar(const unsigned char * bits, unsigned char * pixels, int count, int start)
+{
+  for (int x = start; x < count; x++)
+    pixels[x] = (bits[x / 8] >> (7 - x % 8)) & 1;
+}
+
+
+void SDFF_Simd::edtScanDownScalar(const unsigned char * ink, const int * prevRow, int * row, int width, int start)
+{
+  // ink pixel resets outer distance and continues inner one, background pixel does the opposite
+  for (int x = start; x < width; x++)
+  {
+    int mask = ink[x] ? 0 : -1;
+    row[x] = (prevRow[x] + 1) & mask;
+    row[x + width] = (prevRow[x + width] + 1) & ~mask;
+  }
+}
+
+
+void SDFF_Simd::edtScanUpScalar(const int * nextRow, int * row, int count, int start)
+{
+  for (int i = start; i < count; i++)
+  {
+    if (nextRow[i] < row[i])
+      row[i] = nextRow[i] + 1;
+  }
+}
+
+
+void SDFF_Simd::edtDistancesScalar(const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width, int start)
+{
+  for (int x = start; x < width; x++)
+  {
+    if (gRow[x])
+      distances[x] = std::sqrtf((float)glm::min(distancesSq[x], bandSq));
+    else
+      distances[x] = 1 - std::sqrtf((float)glm::min(distancesSq[x + width], bandSq));
+  }
+}
+
+void SDFF_Simd::gatherRowScalar(const float * src, const int * starts, const float * weights, int taps, float * dest, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const float * srcTaps = src + starts[i];
+    const float * tapWeights = weights + i * taps;
+
+    if (taps % 8)
+    {
+      float sum = 0.0f;
+
+      for (int k = 0; k < taps; k++)
+        sum += tapWeights[k] * srcTaps[k];
+
+      dest[i] = sum;
+      continue;
+    }
+
+    // same order of additions as in the SIMD kernels
+    float sums[8] = {};
+
+    for (int k = 0; k < taps; k += 8)
+    {
+      for (int j = 0; j < 8; j++)
+        sums[j] += tapWeights[k + j] * srcTaps[k + j];
+    }
+
+    dest[i] = ((sums[0] + sums[4]) + (sums[2] + sums[6])) + ((sums[1] + sums[5]) + (sums[3] + sums[7]));
+  }
+}
+
+
+void SDFF_Simd::accumulateRowScalar(float weight, const float * src, float * dest, int count, int start)
+{
+  for (int i = start; i < count; i++)
+    dest[i] += weight * src[i];
+}
+
+#ifdef SDFF_SIMD_X86
+
+SDFF_TARGET_SSE41
+void SDFF_Simd::unpackBitsSse41(const unsigned char * bits, unsigned char * pixels, int count)
+{
+  // every byte of bits is spread over 8 lanes and tested against the bit of its lane
+  const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+  const __m128i laneBits = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+  const __m128i one = _mm_set1_epi8(1);
+  int x = 0;
+
+  for (; x + 16 <= count; x += 16)
+  {
+    unsigned short word;
+    memcpy(&word, bits + x / 8, sizeof(word));
+    __m128i bytes = _mm_shuffle_epi8(_mm_cvtsi32_si128(word), spread);
+    __m128i set = _mm_cmpeq_epi8(_mm_and_si128(bytes, laneBits), laneBits);
+    _mm_storeu_si128((__m128i *)(pixels + x), _mm_and_si128(set, one));
+  }
+
+  unpackBitsScalar(bits, pixels, count, x);
+}
+
+
+SDFF_TARGET_SSE41
+void SDFF_Simd::edtScanDownSse41(const unsigned char * ink, const int * prevRow, int * row, int width)
+{
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i zero = _mm_setzero_si128();
+  int x = 0;
+
+  for (; x + 4 <= width; x += 4)
+  {
+    int inkBytes;
+    memcpy(&inkBytes, ink + x, sizeof(inkBytes));
+    __m128i mask = _mm_cmpeq_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(inkBytes)), zero);
+    __m128i outer = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(prevRow + x)), one);
+    __m128i inner = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(prevRow + x + width)), one);
+    _mm_storeu_si128((__m128i *)(row + x), _mm_and_si128(mask, outer));
+    _mm_storeu_si128((__m128i *)(row + x + width), _mm_andnot_si128(mask, inner));
+  }
+
+  edtScanDownScalar(ink, prevRow, row, width, x);
+}
+
+
+SDFF_TARGET_SSE41
+void SDFF_Simd::edtScanUpSse41(const int * nextRow, int * row, int count)
+{
+  const __m128i one = _mm_set1_epi32(1);
+  int i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i next = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(nextRow + i)), one);
+    __m128i cur = _mm_loadu_si128((const __m128i *)(row + i));
+    _mm_storeu_si128((__m128i *)(row + i), _mm_min_epi32(cur, next));
+  }
+
+  edtScanUpScalar(nextRow, row, count, i);
+}
+
+
+SDFF_TARGET_SSE41
+void SDFF_Simd::edtDistancesSse41(const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width)
+{
+  // squared distances under the band fit int range, so the signed conversion is exact as the scalar one
+  const __m128i limit = _mm_set1_epi32((int)bandSq);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 one = _mm_set1_ps(1.0f);
+  int x = 0;
+
+  for (; x + 4 <= width; x += 4)
+  {
+    __m128i outerSq = _mm_min_epu32(_mm_loadu_si128((const __m128i *)(distancesSq + x)), limit);
+    __m128i innerSq = _mm_min_epu32(_mm_loadu_si128((const __m128i *)(distancesSq + x + width)), limit);
+    __m128 outer = _mm_sqrt_ps(_mm_cvtepi32_ps(outerSq));
+    __m128 inner = _mm_sub_ps(one, _mm_sqrt_ps(_mm_cvtepi32_ps(innerSq)));
+    __m128 ink = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(gRow + x)), zero));
+    _mm_storeu_ps(distances + x, _mm_blendv_ps(outer, inner, ink));
+  }
+
+  edtDistancesScalar(gRow, distancesSq, bandSq, distances, width, x);
+}
+
+
+SDFF_TARGET_SSE41
+void SDFF_Simd::gatherRowSse41(const float * src, const int * starts, const float * weights, int taps, float * dest, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const float * srcTaps = src + starts[i];
+    const float * tapWeights = weights + i * taps;
+    __m128 sums0 = _mm_setzero_ps();
+    __m128 sums1 = _mm_setzero_ps();
+
+    for (int k = 0; k < taps; k += 8)
+    {
+      sums0 = _mm_add_ps(sums0, _mm_mul_ps(_mm_loadu_ps(tapWeights + k), _mm_loadu_ps(srcTaps + k)));
+      sums1 = _mm_add_ps(sums1, _mm_mul_ps(_mm_loadu_ps(tapWeights + k + 4), _mm_loadu_ps(srcTaps + k + 4)));
+    }
+
+    __m128 sums = _mm_add_ps(sums0, sums1);
+    sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+    sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1));
+    dest[i] = _mm_cvtss_f32(sums);
+  }
+}
+
+
+SDFF_TARGET_SSE41
+void SDFF_Simd::accumulateRowSse41(float weight, const float * src, float * dest, int count)
+{
+  const __m128 w = _mm_set1_ps(weight);
+  int i = 0;
+
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+
+  accumulateRowScalar(weight, src, dest, count, i);
+}
+
+
+SDFF_TARGET_AVX2
+void SDFF_Simd::unpackBitsAvx2(const unsigned char * bits, unsigned char * pixels, int count)
+{
+  // byte shuffles stay inside 128-bit lanes, so the 4 bytes are broadcast to both of them
+  const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                          2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  const __m256i laneBits = _mm256_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1,
+                                            -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+  const __m256i one = _mm256_set1_epi8(1);
+  int x = 0;
+
+  for (; x + 32 <= count; x += 32)
+  {
+    int word;
+    memcpy(&word, bits + x / 8, sizeof(word));
+    __m256i bytes = _mm256_shuffle_epi8(_mm256_set1_epi32(word), spread);
+    __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, laneBits), laneBits);
+    _mm256_storeu_si256((__m256i *)(pixels + x), _mm256_and_si256(set, one));
+  }
+
+  unpackBitsScalar(bits, pixels, count, x);
+}
+
+
+SDFF_TARGET_AVX2
+void SDFF_Simd::edtScanDownAvx2(const unsigned char * ink, const int * prevRow, int * row, int width)
+{
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i zero = _mm256_setzero_si256();
+  int x = 0;
+
+  for (; x + 8 <= width; x += 8)
+  {
+    __m128i inkBytes = _mm_loadl_epi64((const __m128i *)(ink + x));
+    __m256i mask = _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(inkBytes), zero);
+    __m256i outer = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(prevRow + x)), one);
+    __m256i inner = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(prevRow + x + width)), one);
+    _mm256_storeu_si256((__m256i *)(row + x), _mm256_and_si256(mask, outer));
+    _mm256_storeu_si256((__m256i *)(row + x + width), _mm256_andnot_si256(mask, inner));
+  }
+
+  edtScanDownScalar(ink, prevRow, row, width, x);
+}
+
+
+SDFF_TARGET_AVX2
+void SDFF_Simd::edtScanUpAvx2(const int * nextRow, int * row, int count)
+{
+  const __m256i one = _mm256_set1_epi32(1);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i next = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(nextRow + i)), one);
+    __m256i cur = _mm256_loadu_si256((const __m256i *)(row + i));
+    _mm256_storeu_si256((__m256i *)(row + i), _mm256_min_epi32(cur, next));
+  }
+
+  edtScanUpScalar(nextRow, row, count, i);
+}
+
+
+SDFF_TARGET_AVX2
+void SDFF_Simd::edtDistancesAvx2(const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width)
+{
+  const __m256i limit = _mm256_set1_epi32((int)bandSq);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  int x = 0;
+
+  for (; x + 8 <= width; x += 8)
+  {
+    __m256i outerSq = _mm256_min_epu32(_mm256_loadu_si256((const __m256i *)(distancesSq + x)), limit);
+    __m256i innerSq = _mm256_min_epu32(_mm256_loadu_si256((const __m256i *)(distancesSq + x + width)), limit);
+    __m256 outer = _mm256_sqrt_ps(_mm256_cvtepi32_ps(outerSq));
+    __m256 inner = _mm256_sub_ps(one, _mm256_sqrt_ps(_mm256_cvtepi32_ps(innerSq)));
+    __m256 ink = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(gRow + x)), zero));
+    _mm256_storeu_ps(distances + x, _mm256_blendv_ps(outer, inner, ink));
+  }
+
+  edtDistancesScalar(gRow, distancesSq, bandSq, distances, width, x);
+}
+
+
+SDFF_TARGET_AVX2
+void SDFF_Simd::gatherRowAvx2(const float * src, const int * starts, const float * weights, int taps, float * dest, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const float * srcTaps = src + starts[i];
+    const float * tapWeights = weights + i * taps;
+    __m256 sums8 = _mm256_setzero_ps();
+
+    for (int k = 0; k < taps; k += 8)
+      sums8 = _mm256_add_ps(sums8, _mm256_mul_ps(_mm256_loadu_ps(tapWeights + k), _mm256_loadu_ps(srcTaps + k)));
+
+    __m128 sums = _mm_add_ps(_mm256_castps256_ps128(sums8), _mm256_extractf128_ps(sums8, 1));
+    sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+    sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1));
+    dest[i] = _mm_cvtss_f32(sums);
+  }
+}
+
+
+SDFF_TARGET_AVX2
+void SDFF_Simd::accumulateRowAvx2(float weight, const float * src, float * dest, int count)
+{
+  const __m256 w = _mm256_set1_ps(weight);
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_loadu_ps(dest + i), _mm256_mul_ps(w, _mm256_loadu_ps(src + i))));
+
+  accumulateRowScalar(weight, src, dest, count, i);
+}
+
+#endif
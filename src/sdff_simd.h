@@ -0,0 +1,59 @@
+#pragma once
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SDFF_SIMD_X86
+#endif
+
+enum SDFF_SimdLevel
+{
+  SDFF_SIMD_SCALAR = 0,
+  SDFF_SIMD_SSE41,
+  SDFF_SIMD_AVX2
+};
+
+// Vectorized kernels of the distance transform and resampling with runtime CPU dispatch.
+// Every kernel has a scalar version which is used as the reference for validation of the SIMD ones.
+class SDFF_Simd
+{
+public:
+  static SDFF_SimdLevel detectLevel();
+
+  // Expands count pixels of a 1 bit per pixel row, most significant bit first, into one 0 or 1 byte per pixel
+  static void unpackBits(SDFF_SimdLevel level, const unsigned char * bits, unsigned char * pixels, int count);
+  // Meijster first stage Scan 1 for a whole row of columns.
+  // prevRow and row hold outer distances in [0, width) followed by inner ones in [width, 2 * width).
+  static void edtScanDown(SDFF_SimdLevel level, const unsigned char * ink, const int * prevRow, int * row, int width);
+  // Meijster first stage Scan 2: row[i] = min(row[i], nextRow[i] + 1)
+  static void edtScanUp(SDFF_SimdLevel level, const int * nextRow, int * row, int count);
+  // Square roots of the second stage. distancesSq holds outer squared distances followed by inner ones like gRow,
+  // background pixels take sqrt(min(outer, bandSq)), ink pixels (gRow[x] == 0) take 1 - sqrt(min(inner, bandSq)).
+  static void edtDistances(SDFF_SimdLevel level, const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width);
+  // dest[i] = sum of weights[i * taps + k] * src[starts[i] + k] over k in [0, taps).
+  // Sums are taken in 8 interleaved partial sums when taps is a multiple of 8, so every level gives the same bits.
+  static void gatherRow(SDFF_SimdLevel level, const float * src, const int * starts, const float * weights, int taps, float * dest, int count);
+  // dest[i] += weight * src[i]
+  static void accumulateRow(SDFF_SimdLevel level, float weight, const float * src, float * dest, int count);
+
+private:
+  static void unpackBitsScalar(const unsigned char * bits, unsigned char * pixels, int count, int start);
+  static void edtScanDownScalar(const unsigned char * ink, const int * prevRow, int * row, int width, int start);
+  static void edtScanUpScalar(const int * nextRow, int * row, int count, int start);
+  static void edtDistancesScalar(const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width, int start);
+  static void gatherRowScalar(const float * src, const int * starts, const float * weights, int taps, float * dest, int count);
+  static void accumulateRowScalar(float weight, const float * src, float * dest, int count, int start);
+
+#ifdef SDFF_SIMD_X86
+  static void unpackBitsSse41(const unsigned char * bits, unsigned char * pixels, int count);
+  static void edtScanDownSse41(const unsigned char * ink, const int * prevRow, int * row, int width);
+  static void edtScanUpSse41(const int * nextRow, int * row, int count);
+  static void edtDistancesSse41(const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width);
+  static void unpackBitsAvx2(const unsigned char * bits, unsigned char * pixels, int count);
+  static void edtScanDownAvx2(const unsigned char * ink, const int * prevRow, int * row, int width);
+  static void edtScanUpAvx2(const int * nextRow, int * row, int count);
+  static void edtDistancesAvx2(const int * gRow, const unsigned int * distancesSq, unsigned int bandSq, float * distances, int width);
+  static void gatherRowSse41(const float * src, const int * starts, const float * weights, int taps, float * dest, int count);
+  static void accumulateRowSse41(float weight, const float * src, float * dest, int count);
+  static void gatherRowAvx2(const float * src, const int * starts, const float * weights, int taps, float * dest, int count);
+  static void accumulateRowAvx2(float weight, const float * src, float * dest, int count);
+#endif
+};
@@ -0,0 +1,234 @@
+#include "static_headers.h"
+
+#include "sdff_thread_pool.h"
+
+SDFF_ThreadPool::SDFF_ThreadPool() :
+  job_(NULL),
+  activeWorkers_(0),
+  generation_(0),
+  stopping_(false)
+{
+  resetStats();
+}
+
+
+SDFF_ThreadPool::~SDFF_ThreadPool()
+{
+  shutdown();
+}
+
+
+void SDFF_ThreadPool::init(int threadCount)
+{
+  assert(threadCount > 0);
+  shutdown();
+  taskQueues_.reset(new TaskQueue[threadCount]);
+
+  for (int threadIndex = 1; threadIndex < threadCount; threadIndex++)
+    threads_.push_back(std::thread(&SDFF_ThreadPool::workerProc, this, threadIndex, generation_));
+
+  resetStats();
+}
+
+
+void SDFF_ThreadPool::resetStats()
+{
+  SDFF_WorkerStats emptyStats = { 0, 0, 0.0, 0.0 };
+  stats_.assign(threadCount(), emptyStats);
+}
+
+
+void SDFF_ThreadPool::parallelFor(int count, int blockSize, const RangeFunc & func)
+{
+  assert(blockSize > 0);
+
+  if (count <= 0)
+    return;
+
+  // nothing to share, so avoid waking up the workers
+  if (threads_.empty() || count <= blockSize)
+  {
+    func(0, count, 0);
+    return;
+  }
+
+  std::atomic<int> nextBlock(0);
+
+  JobFunc job = [&](int threadIndex)
+  {
+    for (;;)
+    {
+      int first = nextBlock.fetch_add(1) * blockSize;
+
+      if (first >= count)
+        break;
+
+      func(first, glm::min(first + blockSize, count), threadIndex);
+    }
+  };
+
+  run(job);
+}
+
+
+void SDFF_ThreadPool::runTasks(int count, const float * costs, const TaskFunc & func, bool recordStats)
+{
+  if (count <= 0)
+    return;
+
+  int threadCount = this->threadCount();
+  std::vector<int> order(count);
+
+  for (int i = 0; i < count; i++)
+    order[i] = i;
+
+  std::stable_sort(order.begin(), order.end(), [costs](int left, int right) { return costs[left] > costs[right]; });
+
+  // longest processing time first: every next task goes to the least loaded thread,
+  // so each queue is ordered from the most expensive task to the cheapest one
+  std::vector<double> seededCosts(threadCount, 0.0);
+
+  for (int i = 0; i < count; i++)
+  {
+    int threadIndex = int(std::min_element(seededCosts.begin(), seededCosts.end()) - seededCosts.begin());
+    taskQueues_[threadIndex].tasks.push_back(order[i]);
+    seededCosts[threadIndex] += glm::max(costs[order[i]], 1.0f);
+  }
+
+  SDFF_WorkerStats emptyStats = { 0, 0, 0.0, 0.0 };
+  std::vector<SDFF_WorkerStats> unrecordedStats(recordStats ? 0 : threadCount, emptyStats);
+  std::vector<SDFF_WorkerStats> & runStats = recordStats ? stats_ : unrecordedStats;
+  std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+
+  JobFunc job = [&](int threadIndex)
+  {
+    SDFF_WorkerStats & stats = runStats[threadIndex];
+    int taskIndex;
+
+    for (;;)
+    {
+      if (!popTask(threadIndex, taskIndex))
+      {
+        if (stealTask(threadIndex, taskIndex))
+          stats.stealCount++;
+        else
+          break;
+      }
+
+      std::chrono::steady_clock::time_point taskStart = std::chrono::steady_clock::now();
+      func(taskIndex, threadIndex);
+      stats.busyTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - taskStart).count();
+      stats.taskCount++;
+    }
+  };
+
+  run(job);
+
+  double runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+  for (int threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    runStats[threadIndex].totalTime += runTime;
+}
+
+
+bool SDFF_ThreadPool::popTask(int threadIndex, int & taskIndex)
+{
+  TaskQueue & queue = taskQueues_[threadIndex];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+
+  if (queue.tasks.empty())
+    return false;
+
+  taskIndex = queue.tasks.front();
+  queue.tasks.pop_front();
+
+  return true;
+}
+
+
+bool SDFF_ThreadPool::stealTask(int threadIndex, int & taskIndex)
+{
+  int threadCount = this->threadCount();
+
+  for (int i = 1; i < threadCount; i++)
+  {
+    TaskQueue & queue = taskQueues_[(threadIndex + i) % threadCount];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (!queue.tasks.empty())
+    {
+      taskIndex = queue.tasks.back();
+      queue.tasks.pop_back();
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+void SDFF_ThreadPool::run(const JobFunc & job)
+{
+  if (threads_.empty())
+  {
+    job(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &job;
+    activeWorkers_ = (int)threads_.size();
+    generation_++;
+  }
+
+  startCondition_.notify_all();
+  job(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  doneCondition_.wait(lock, [this] { return activeWorkers_ == 0; });
+  job_ = NULL;
+}
+
+
+void SDFF_ThreadPool::shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+
+  startCondition_.notify_all();
+
+  for (std::vector<std::thread>::iterator threadIt = threads_.begin(); threadIt != threads_.end(); ++threadIt)
+    threadIt->join();
+
+  threads_.clear();
+  stopping_ = false;
+}
+
+
+// generation is passed by the creating thread, a worker which starts late must not skip the first job
+void SDFF_ThreadPool::workerProc(int threadIndex, unsigned int generation)
+{
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      startCondition_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+
+      if (stopping_)
+        return;
+
+      generation = generation_;
+    }
+
+    (*job_)(threadIndex);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (--activeWorkers_ == 0)
+      doneCondition_.notify_one();
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Load balance report of one pool thread, accumulated over the task runs since the last reset
+struct SDFF_WorkerStats
+{
+  int taskCount;
+  int stealCount;
+  // seconds spent inside tasks
+  double busyTime;
+  // seconds of the task runs the thread took part in
+  double totalTime;
+
+  float utilization() const { return totalTime > 0.0 ? float(busyTime / totalTime) : 0.0f; }
+};
+
+// Persistent worker threads running blocks of an index range or a set of independent tasks.
+// The calling thread takes part in the work as thread 0, so a pool of one thread runs everything inline.
+class SDFF_ThreadPool
+{
+public:
+  typedef std::function<void(int first, int last, int threadIndex)> RangeFunc;
+  typedef std::function<void(int taskIndex, int threadIndex)> TaskFunc;
+
+  SDFF_ThreadPool();
+  ~SDFF_ThreadPool();
+
+  void init(int threadCount);
+  int threadCount() const { return (int)threads_.size() + 1; }
+  void parallelFor(int count, int blockSize, const RangeFunc & func);
+  // Runs count tasks with work stealing. Tasks are seeded most expensive first and spread
+  // so that estimated costs of the threads are even, idle threads steal the cheapest remaining tasks.
+  // Runs without recordStats leave stats() as they are.
+  void runTasks(int count, const float * costs, const TaskFunc & func, bool recordStats = true);
+  const std::vector<SDFF_WorkerStats> & stats() const { return stats_; }
+  void resetStats();
+
+private:
+  typedef std::function<void(int threadIndex)> JobFunc;
+
+  struct TaskQueue
+  {
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+
+  std::vector<std::thread> threads_;
+  std::unique_ptr<TaskQueue[]> taskQueues_;
+  std::vector<SDFF_WorkerStats> stats_;
+  std::mutex mutex_;
+  std::condition_variable startCondition_;
+  std::condition_variable doneCondition_;
+  const JobFunc * job_;
+  int activeWorkers_;
+  unsigned int generation_;
+  bool stopping_;
+
+  void run(const JobFunc & job);
+  void shutdown();
+  void workerProc(int threadIndex, unsigned int generation);
+  bool popTask(int threadIndex, int & taskIndex);
+  bool stealTask(int threadIndex, int & taskIndex);
+};
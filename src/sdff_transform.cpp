@@ -0,0 +1,582 @@
+#include "static_headers.h"
+
+#include "sdff_transform.h"
+
+//  Based on "General algorithm for computing distance transforms in linear time"
+//  by A.MEIJSTER, J.B.T.M.ROERDINK and W.H.HESSELINK, University of Groningen
+class SDFF_MeijsterTransform : public SDFF_DistanceTransform
+{
+public:
+  // column distances of the whole field
+  int pixelBytes() const override { return baseBytes + (int)sizeof(int); }
+
+protected:
+  void transform(const unsigned char * features, int width, int height, int band, float * distances) override;
+
+private:
+  std::vector<int> g_;
+  std::vector<int> envelopes_;
+};
+
+
+//  Based on "Distance Transforms of Sampled Functions"
+//  by P.F.FELZENSZWALB and D.P.HUTTENLOCHER, Theory of Computing 8 (2012)
+class SDFF_FelzenszwalbTransform : public SDFF_DistanceTransform
+{
+public:
+  // envelope buffers hold a single line
+  int pixelBytes() const override { return baseBytes; }
+
+protected:
+  void transform(const unsigned char * features, int width, int height, int band, float * distances) override;
+
+private:
+  std::vector<float> squares_;
+  std::vector<float> line_;
+  std::vector<float> lineResult_;
+  std::vector<int> vertices_;
+  std::vector<float> bounds_;
+
+  void envelope(int count);
+};
+
+
+//  Based on "Euclidean distance mapping" by P.E.DANIELSSON,
+//  Computer Graphics and Image Processing 14 (1980), 8-neighbor sequential variant
+class SDFF_Ssedt8Transform : public SDFF_DistanceTransform
+{
+public:
+  int pixelBytes() const override { return baseBytes + (int)sizeof(Offset); }
+
+protected:
+  void transform(const unsigned char * features, int width, int height, int band, float * distances) override;
+
+private:
+  struct Offset
+  {
+    int dx;
+    int dy;
+
+    int lengthSq() const { return dx * dx + dy * dy; }
+  };
+
+  std::vector<Offset> offsets_;
+};
+
+
+//  Based on "Jump Flooding in GPU with Applications to Voronoi Diagram and Distance Transform"
+//  by G.RONG and T.S.TAN, I3D 2006
+class SDFF_JumpFloodTransform : public SDFF_DistanceTransform
+{
+public:
+  // seeds of both flooding passes
+  int pixelBytes() const override { return baseBytes + 2 * (int)sizeof(Seed); }
+
+protected:
+  void transform(const unsigned char * features, int width, int height, int band, float * distances) override;
+
+private:
+  // position of the nearest feature found so far, x is -1 before any
+  struct Seed
+  {
+    short x;
+    short y;
+  };
+
+  std::vector<Seed> seeds_;
+  std::vector<Seed> nextSeeds_;
+  int width_;
+  int height_;
+
+  Seed nearest(int x, int y, int step, bool checked) const;
+  static void closer(Seed seed, int x, int y, Seed & best, int & bestDistanceSq);
+};
+
+
+class SDFF_BruteForceTransform : public SDFF_DistanceTransform
+{
+public:
+  // every pixel can be a boundary one
+  int pixelBytes() const override { return baseBytes + (int)sizeof(int); }
+
+protected:
+  void transform(const unsigned char * features, int width, int height, int band, float * distances) override;
+
+private:
+  std::vector<int> rowStarts_;
+  std::vector<int> boundary_;
+};
+
+
+SDFF_DistanceTransform * SDFF_DistanceTransform::create(SDFF_Transform transform)
+{
+  switch (transform)
+  {
+  case SDFF_TRANSFORM_MEIJSTER:
+    return new SDFF_MeijsterTransform();
+  case SDFF_TRANSFORM_FELZENSZWALB:
+    return new SDFF_FelzenszwalbTransform();
+  case SDFF_TRANSFORM_SSEDT8:
+    return new SDFF_Ssedt8Transform();
+  case SDFF_TRANSFORM_JUMP_FLOOD:
+    return new SDFF_JumpFloodTransform();
+  case SDFF_TRANSFORM_BRUTE_FORCE:
+    return new SDFF_BruteForceTransform();
+  }
+
+  assert(0);
+  return NULL;
+}
+
+
+void SDFF_DistanceTransform::createSdf(const FT_Bitmap & bitmap, int falloff, int band, DistanceFieldVector & result)
+{
+  createSdf(bitmap, falloff, band, 0, bitmap.rows + 2 * falloff, result);
+}
+
+
+void SDFF_DistanceTransform::createSdf(const FT_Bitmap & bitmap, int falloff, int band, int firstRow, int rowCount, DistanceFieldVector & result)
+{
+  assert(band >= 0);
+  assert(falloff >= 0);
+  assert(firstRow >= 0 && rowCount > 0 && firstRow + rowCount <= (int)bitmap.rows + 2 * falloff);
+  int width = bitmap.width + 2 * falloff;
+  int height = rowCount;
+  int size = width * height;
+  ink_.assign(size, 0);
+
+  for (int y = glm::max(firstRow - falloff, 0); y < glm::min(firstRow + rowCount - falloff, (int)bitmap.rows); y++)
+  {
+    const unsigned char * bits = bitmap.buffer + y * bitmap.pitch;
+    unsigned char * inkRow = &ink_[(y + falloff - firstRow) * width + falloff];
+
+    for (int x = 0; x < (int)bitmap.width; x++)
+      inkRow[x] = (bits[x / 8] >> (7 - x % 8)) & 1;
+  }
+
+  background_.resize(size);
+
+  for (int i = 0; i < size; i++)
+    background_[i] = !ink_[i];
+
+  result.resize(size);
+  inner_.resize(size);
+  transform(ink_.data(), width, height, band, result.data());
+  transform(background_.data(), width, height, band, inner_.data());
+
+  for (int i = 0; i < size; i++)
+  {
+    if (ink_[i])
+      result[i] = 1 - inner_[i];
+  }
+}
+
+
+void SDFF_MeijsterTransform::transform(const unsigned char * features, int width, int height, int, float * distances)
+{
+  const int inf = width + height;
+  g_.resize(width * height);
+  envelopes_.resize(2 * width);
+  int * g = g_.data();
+  int * s = envelopes_.data();
+  int * t = s + width;
+
+  // First stage, column distances
+  for (int x = 0; x < width; x++)
+  {
+    g[x] = features[x] ? 0 : inf;
+
+    for (int y = 1; y < height; y++)
+      g[x + y * width] = features[x + y * width] ? 0 : g[x + (y - 1) * width] + 1;
+
+    for (int y = height - 2; y >= 0; y--)
+    {
+      if (g[x + (y + 1) * width] < g[x + y * width])
+        g[x + y * width] = g[x + (y + 1) * width] + 1;
+    }
+  }
+
+  // Second stage, lower envelope of the column parabolas along every row
+  for (int y = 0; y < height; y++)
+  {
+    const int * gRow = g + y * width;
+    int q = 0;
+    s[0] = 0;
+    t[0] = 0;
+
+    for (int u = 1; u < width; u++)
+    {
+      while (q >= 0 && (t[q] - s[q]) * (t[q] - s[q]) + gRow[s[q]] * gRow[s[q]] > (t[q] - u) * (t[q] - u) + gRow[u] * gRow[u])
+        q--;
+
+      if (q < 0)
+      {
+        q = 0;
+        s[0] = u;
+      }
+      else
+      {
+        int w = 1 + (u * u - s[q] * s[q] + gRow[u] * gRow[u] - gRow[s[q]] * gRow[s[q]]) / (2 * (u - s[q]));
+
+        if (w < width)
+        {
+          q++;
+          s[q] = u;
+          t[q] = w;
+        }
+      }
+    }
+
+    for (int u = width - 1; u >= 0; u--)
+    {
+      distances[u + y * width] = std::sqrtf((float)((u - s[q]) * (u - s[q]) + gRow[s[q]] * gRow[s[q]]));
+
+      if (u == t[q])
+        q--;
+    }
+  }
+}
+
+
+// One dimensional transform of line_: lineResult_[q] = min over p of (q - p)^2 + line_[p]
+void SDFF_FelzenszwalbTransform::envelope(int count)
+{
+  const float * f = line_.data();
+  const float * squares = squares_.data();
+  int * v = vertices_.data();
+  float * z = bounds_.data();
+  int k = 0;
+  v[0] = 0;
+  z[0] = -FLT_MAX;
+  z[1] = FLT_MAX;
+
+  for (int q = 1; q < count; q++)
+  {
+    float s = ((f[q] + squares[q]) - (f[v[k]] + squares[v[k]])) / (2 * q - 2 * v[k]);
+
+    while (s <= z[k])
+    {
+      k--;
+      s = ((f[q] + squares[q]) - (f[v[k]] + squares[v[k]])) / (2 * q - 2 * v[k]);
+    }
+
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = FLT_MAX;
+  }
+
+  k = 0;
+
+  for (int q = 0; q < count; q++)
+  {
+    while (z[k + 1] < q)
+      k++;
+
+    lineResult_[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+  }
+}
+
+
+void SDFF_FelzenszwalbTransform::transform(const unsigned char * features, int width, int height, int, float * distances)
+{
+  // far enough to never win, small enough to keep the intersections finite
+  const float inf = 1e20f;
+  int count = glm::max(width, height);
+  squares_.resize(count);
+  line_.resize(count);
+  lineResult_.resize(count);
+  vertices_.resize(count);
+  bounds_.resize(count + 1);
+
+  for (int i = 0; i < count; i++)
+    squares_[i] = (float)i * i;
+
+  for (int x = 0; x < width; x++)
+  {
+    for (int y = 0; y < height; y++)
+      line_[y] = features[x + y * width] ? 0 : inf;
+
+    envelope(height);
+
+    for (int y = 0; y < height; y++)
+      distances[x + y * width] = lineResult_[y];
+  }
+
+  for (int y = 0; y < height; y++)
+  {
+    float * row = distances + y * width;
+    std::copy(row, row + width, line_.begin());
+    envelope(width);
+
+    // rows without any feature keep the huge value, the interface asks for width + height at least
+    for (int x = 0; x < width; x++)
+      row[x] = glm::min(std::sqrtf(lineResult_[x]), (float)(width + height));
+  }
+}
+
+
+void SDFF_Ssedt8Transform::transform(const unsigned char * features, int width, int height, int, float * distances)
+{
+  // offsets of pixels without a feature found yet, squared length still fits int
+  const int inf = glm::max(width + height, 9999);
+  offsets_.resize(width * height);
+  Offset * grid = offsets_.data();
+
+  for (int i = 0; i < width * height; i++)
+  {
+    grid[i].dx = features[i] ? 0 : inf;
+    grid[i].dy = features[i] ? 0 : inf;
+  }
+
+  struct
+  {
+    Offset * grid;
+    int width;
+    int height;
+
+    void compare(int x, int y, int offsetX, int offsetY)
+    {
+      int otherX = x + offsetX;
+      int otherY = y + offsetY;
+
+      if (otherX < 0 || otherX >= width || otherY < 0 || otherY >= height)
+        return;
+
+      Offset & offset = grid[x + y * width];
+      Offset other = grid[otherX + otherY * width];
+      other.dx += offsetX;
+      other.dy += offsetY;
+
+      if (other.lengthSq() < offset.lengthSq())
+        offset = other;
+    }
+  } pass = { grid, width, height };
+
+  // Pass 1, down the rows
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      pass.compare(x, y, -1, 0);
+      pass.compare(x, y, 0, -1);
+      pass.compare(x, y, -1, -1);
+      pass.compare(x, y, 1, -1);
+    }
+
+    for (int x = width - 1; x >= 0; x--)
+      pass.compare(x, y, 1, 0);
+  }
+
+  // Pass 2, up the rows
+  for (int y = height - 1; y >= 0; y--)
+  {
+    for (int x = width - 1; x >= 0; x--)
+    {
+      pass.compare(x, y, 1, 0);
+      pass.compare(x, y, 0, 1);
+      pass.compare(x, y, -1, 1);
+      pass.compare(x, y, 1, 1);
+    }
+
+    for (int x = 0; x < width; x++)
+      pass.compare(x, y, -1, 0);
+  }
+
+  for (int i = 0; i < width * height; i++)
+    distances[i] = glm::min(std::sqrtf((float)grid[i].lengthSq()), (float)(width + height));
+}
+
+
+void SDFF_JumpFloodTransform::transform(const unsigned char * features, int width, int height, int band, float * distances)
+{
+  assert(width <= SHRT_MAX && height <= SHRT_MAX);
+  int size = width * height;
+  seeds_.resize(size);
+  nextSeeds_.resize(size);
+  width_ = width;
+  height_ = height;
+
+  for (int y = 0; y < height; y++)
+  for (int x = 0; x < width; x++)
+  {
+    Seed seed = { (short)(features[x + y * width] ? x : -1), (short)y };
+    seeds_[x + y * width] = seed;
+  }
+
+  int step = 1;
+
+  while (step * 2 < glm::max(width, height))
+    step *= 2;
+
+  // steps from k down to 1 reach features up to 2k - 1 away, within the band the power of two above it is enough
+  if (band)
+  {
+    int bandStep = 1;
+
+    while (bandStep <= band)
+      bandStep *= 2;
+
+    step = glm::min(step, bandStep);
+  }
+
+  // halving steps down to 1, then one more pass of step 1 which fixes most of the remaining errors
+  for (bool extraPass = false; step > 0; )
+  {
+    // pixels with all neighbors of the step inside the field skip the bounds checks
+    int innerLeft = glm::min(step, width);
+    int innerRight = glm::max(width - step, innerLeft);
+
+    for (int y = 0; y < height; y++)
+    {
+      Seed * nextRow = &nextSeeds_[y * width];
+
+      if (y < step || y >= height - step)
+      {
+        for (int x = 0; x < width; x++)
+          nextRow[x] = nearest(x, y, step, true);
+
+        continue;
+      }
+
+      for (int x = 0; x < innerLeft; x++)
+        nextRow[x] = nearest(x, y, step, true);
+
+      for (int x = innerLeft; x < innerRight; x++)
+        nextRow[x] = nearest(x, y, step, false);
+
+      for (int x = innerRight; x < width; x++)
+        nextRow[x] = nearest(x, y, step, true);
+    }
+
+    seeds_.swap(nextSeeds_);
+
+    if (step > 1)
+      step /= 2;
+    else if (!extraPass)
+      extraPass = true;
+    else
+      step = 0;
+  }
+
+  for (int y = 0; y < height; y++)
+  for (int x = 0; x < width; x++)
+  {
+    Seed seed = seeds_[x + y * width];
+    int dx = seed.x - x;
+    int dy = seed.y - y;
+    distances[x + y * width] = seed.x >= 0 ? std::sqrtf((float)(dx * dx + dy * dy)) : (float)(width + height);
+  }
+}
+
+
+// nearest of the seeds of the pixel and its 8 neighbors step pixels away, checked skips neighbors outside of the field
+inline SDFF_JumpFloodTransform::Seed SDFF_JumpFloodTransform::nearest(int x, int y, int step, bool checked) const
+{
+  const Seed * row = &seeds_[y * width_];
+  const Seed * rowAbove = row - step * width_;
+  const Seed * rowBelow = row + step * width_;
+  bool left = !checked || x >= step;
+  bool right = !checked || x < width_ - step;
+  bool above = !checked || y >= step;
+  bool below = !checked || y < height_ - step;
+  Seed best = row[x];
+  int bestDistanceSq = best.x >= 0 ? (best.x - x) * (best.x - x) + (best.y - y) * (best.y - y) : INT_MAX;
+
+  // features and their neighbors already have the nearest seed
+  if (bestDistanceSq <= 1)
+    return best;
+
+  if (above)
+  {
+    if (left)
+      closer(rowAbove[x - step], x, y, best, bestDistanceSq);
+
+    closer(rowAbove[x], x, y, best, bestDistanceSq);
+
+    if (right)
+      closer(rowAbove[x + step], x, y, best, bestDistanceSq);
+  }
+
+  if (left)
+    closer(row[x - step], x, y, best, bestDistanceSq);
+
+  if (right)
+    closer(row[x + step], x, y, best, bestDistanceSq);
+
+  if (below)
+  {
+    if (left)
+      closer(rowBelow[x - step], x, y, best, bestDistanceSq);
+
+    closer(rowBelow[x], x, y, best, bestDistanceSq);
+
+    if (right)
+      closer(rowBelow[x + step], x, y, best, bestDistanceSq);
+  }
+
+  return best;
+}
+
+
+// takes the seed when it is nearer to the pixel than the best one, without a branch which would be mispredicted all the time
+inline void SDFF_JumpFloodTransform::closer(Seed seed, int x, int y, Seed & best, int & bestDistanceSq)
+{
+  int distanceSq = (seed.x - x) * (seed.x - x) + (seed.y - y) * (seed.y - y);
+  bool nearer = seed.x >= 0 && distanceSq < bestDistanceSq;
+  best = nearer ? seed : best;
+  bestDistanceSq = nearer ? distanceSq : bestDistanceSq;
+}
+
+
+void SDFF_BruteForceTransform::transform(const unsigned char * features, int width, int height, int, float * distances)
+{
+  // the nearest feature of a pixel without one always has a neighbor without feature, so only those are searched
+  rowStarts_.resize(height + 1);
+  boundary_.clear();
+
+  for (int y = 0; y < height; y++)
+  {
+    rowStarts_[y] = (int)boundary_.size();
+
+    for (int x = 0; x < width; x++)
+    {
+      int i = x + y * width;
+
+      if (features[i] && ((x > 0 && !features[i - 1]) || (x < width - 1 && !features[i + 1]) ||
+        (y > 0 && !features[i - width]) || (y < height - 1 && !features[i + width])))
+        boundary_.push_back(x);
+    }
+  }
+
+  rowStarts_[height] = (int)boundary_.size();
+
+  for (int y = 0; y < height; y++)
+  for (int x = 0; x < width; x++)
+  {
+    if (features[x + y * width])
+    {
+      distances[x + y * width] = 0;
+      continue;
+    }
+
+    // rows are visited by growing vertical distance until it alone exceeds the best one
+    int bestSq = (width + height) * (width + height);
+
+    for (int dy = 0; dy < height && dy * dy < bestSq; dy++)
+    {
+      for (int side = dy ? -1 : 1; side <= 1; side += 2)
+      {
+        int row = y + side * dy;
+
+        if (row < 0 || row >= height)
+          continue;
+
+        for (int i = rowStarts_[row]; i < rowStarts_[row + 1]; i++)
+          bestSq = glm::min(bestSq, (boundary_[i] - x) * (boundary_[i] - x) + dy * dy);
+      }
+    }
+
+    distances[x + y * width] = std::sqrtf((float)bestSq);
+  }
+}
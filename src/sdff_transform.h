@@ -0,0 +1,54 @@
+#pragma once
+
+// Distance transform engine of the mono mode
+enum SDFF_Transform
+{
+  // Meijster et al. exact transform with integer arithmetic; the builder runs it fused with downsampling and the narrow band
+  SDFF_TRANSFORM_MEIJSTER = 0,
+  // Felzenszwalb-Huttenlocher lower envelope of parabolas in floating point, exact up to rounding
+  SDFF_TRANSFORM_FELZENSZWALB,
+  // 8-point sequential signed Euclidean transform, two raster passes propagating offsets to the nearest feature, approximate
+  SDFF_TRANSFORM_SSEDT8,
+  // jump flooding with halving steps from the narrow band and one extra pass of step 1, approximate
+  SDFF_TRANSFORM_JUMP_FLOOD,
+  // nearest boundary pixel searched row by row outwards, exact and slow, the reference for the others
+  SDFF_TRANSFORM_BRUTE_FORCE
+};
+
+// Whole-field signed distance transform of a mono bitmap, the interface every engine implements.
+// The builder uses it for the engines other than the fused Meijster one, comparison tools use all of them.
+class SDFF_DistanceTransform
+{
+public:
+  typedef std::vector<float> DistanceFieldVector;
+
+  static SDFF_DistanceTransform * create(SDFF_Transform transform);
+  // exact engines give the same distances, the others can be longer by a fraction of a pixel
+  static bool isExact(SDFF_Transform transform) { return transform != SDFF_TRANSFORM_SSEDT8 && transform != SDFF_TRANSFORM_JUMP_FLOOD; }
+
+  virtual ~SDFF_DistanceTransform() {}
+
+  // Result is the bitmap padded by falloff on each side, the same values as the mono mode transform:
+  // background pixels take the distance between centers to the nearest ink pixel, ink pixels take 1 - the distance
+  // to the nearest background pixel, so the edge is half way between them.
+  // Distances longer than a nonzero band only stay longer than it, engines may stop searching there.
+  void createSdf(const FT_Bitmap & bitmap, int falloff, int band, DistanceFieldVector & result);
+  // transforms only the padded rows [firstRow, firstRow + rowCount) as if everything outside of them were background,
+  // result holds rowCount rows
+  void createSdf(const FT_Bitmap & bitmap, int falloff, int band, int firstRow, int rowCount, DistanceFieldVector & result);
+  // working memory per pixel of the transformed rows, result included
+  virtual int pixelBytes() const = 0;
+
+protected:
+  // ink and background features, inner distances and the result
+  static const int baseBytes = 2 * sizeof(unsigned char) + 2 * sizeof(float);
+
+  // distances from every pixel to the nearest pixel with a nonzero feature, at least width + height when there is none;
+  // with a nonzero band, distances longer than it only need to stay longer
+  virtual void transform(const unsigned char * features, int width, int height, int band, float * distances) = 0;
+
+private:
+  std::vector<unsigned char> ink_;
+  std::vector<unsigned char> background_;
+  std::vector<float> inner_;
+};
@@ -3,14 +3,28 @@
 #pragma warning(push, 3)
 #pragma warning (disable : 4005)
 
+#include <stdio.h>
+#include <float.h>
+#include <limits.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <unordered_set>
 #include <map>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <chrono>
 #include <assert.h>
 #include <GLM/glm.hpp>
 #include "ft2build.h"
 #include FT_FREETYPE_H
+#include FT_OUTLINE_H
 #include "rapidjson/document.h"
 #include "rapidjson/filewritestream.h"
 #include "rapidjson/filereadstream.h"
@@ -0,0 +1,134 @@
+// Reconstruction error of the distance field atlas for every downsampling filter.
+// Glyphs are sampled back from the atlas with bilinear filtering at the source resolution and thresholded
+// at 0.5 of the 8-bit range the way a shader draws them. Pixels whose inside/outside state differs from the mono
+// rendering at the source size are counted as wrong.
+//
+// Usage: sdff_filter_error [font file] [source size] [sdf sizes...]
+// Built by proj/vs14/SDFFFilterError.vcxproj of the SDFFBuilder solution into bin, next to the default font.
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "static_headers.h"
+
+#include "sdff_builder.h"
+#include "Crosy.h"
+
+static const char * filterNames[] = { "box", "tent", "mitchell", "lanczos3" };
+static const char * charString = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz'";
+static const float falloff = 0.125f;
+
+struct ErrorCount
+{
+  long wrong;
+  long ink;
+};
+
+
+// the glyph texels cover the source bitmap padded by the falloff, the same grid as the builder uses
+static void measureGlyph(const SDFF_Bitmap & atlas, const SDFF_Glyph & glyph, const FT_Bitmap & reference, int srcFalloff, float sdfScale, ErrorCount & count)
+{
+  int srcWidth = reference.width + 2 * srcFalloff;
+  int srcHeight = reference.rows + 2 * srcFalloff;
+  int destWidth = (int)glm::ceil(srcWidth * sdfScale);
+  int destHeight = (int)glm::ceil(srcHeight * sdfScale);
+  int left = (int)(glyph.left * atlas.width() + 0.5f);
+  int top = (int)(glyph.top * atlas.height() + 0.5f);
+
+  for (int y = 0; y < srcHeight; y++)
+  for (int x = 0; x < srcWidth; x++)
+  {
+    int bitmapX = x - srcFalloff;
+    int bitmapY = y - srcFalloff;
+    bool ink = bitmapX >= 0 && bitmapY >= 0 && bitmapX < (int)reference.width && bitmapY < (int)reference.rows &&
+               (reference.buffer[bitmapY * reference.pitch + bitmapX / 8] & (0x80 >> (bitmapX % 8)));
+
+    float u = (x + 0.5f) * destWidth / srcWidth - 0.5f;
+    float v = (y + 0.5f) * destHeight / srcHeight - 0.5f;
+    int u0 = (int)glm::floor(u);
+    int v0 = (int)glm::floor(v);
+    float fu = u - u0;
+    float fv = v - v0;
+    float texels[4];
+
+    for (int i = 0; i < 4; i++)
+    {
+      int texelX = glm::clamp(u0 + (i & 1), 0, destWidth - 1);
+      int texelY = glm::clamp(v0 + (i >> 1), 0, destHeight - 1);
+      texels[i] = atlas[left + texelX + (top + texelY) * atlas.width()];
+    }
+
+    float value = (texels[0] * (1 - fu) + texels[1] * fu) * (1 - fv) + (texels[2] * (1 - fu) + texels[3] * fu) * fv;
+    count.ink += ink;
+    count.wrong += ink != (value > 127.5f);
+  }
+}
+
+
+int main(int argc, char * argv[])
+{
+  std::string fontFileName = argc > 1 ? argv[1] : Crosy::getExePath() + "Montserrat-Bold.otf";
+  int sourceFontSize = argc > 2 ? atoi(argv[2]) : 2048;
+  std::vector<int> sdfFontSizes;
+
+  for (int i = 3; i < argc; i++)
+    sdfFontSizes.push_back(atoi(argv[i]));
+
+  if (sdfFontSizes.empty())
+  {
+    sdfFontSizes.push_back(64);
+    sdfFontSizes.push_back(48);
+    sdfFontSizes.push_back(32);
+  }
+
+  // reference rendering, the same load flags as the mono mode of the builder
+  FT_Library ftLibrary;
+  FT_Face ftFace;
+  FT_Init_FreeType(&ftLibrary);
+
+  if (FT_New_Face(ftLibrary, fontFileName.c_str(), 0, &ftFace) || FT_Set_Char_Size(ftFace, sourceFontSize * 64, sourceFontSize * 64, 64, 64))
+  {
+    printf("Can not open %s\n", fontFileName.c_str());
+    return 1;
+  }
+
+  printf("%-10s %8s %10s %10s\n", "filter", "sdf size", "wrong, %", "build, ms");
+
+  for (int sizeIndex = 0; sizeIndex < (int)sdfFontSizes.size(); sizeIndex++)
+  for (int filter = SDFF_FILTER_BOX; filter <= SDFF_FILTER_LANCZOS3; filter++)
+  {
+    int sdfFontSize = sdfFontSizes[sizeIndex];
+    SDFF_Options options;
+    options.filter = (SDFF_Filter)filter;
+    SDFF_Builder sdff;
+    SDFF_Font font;
+    sdff.init(sourceFontSize, sdfFontSize, falloff, options);
+
+    if (sdff.addFont(fontFileName.c_str(), 0, &font) != SDFF_OK)
+      return 1;
+
+    uint64_t buildStartTime = Crosy::getPerformanceCounter();
+    sdff.addChars(font, charString);
+    uint64_t buildTime = Crosy::getPerformanceCounter() - buildStartTime;
+    SDFF_Bitmap atlas;
+    sdff.composeTexture(atlas, false);
+    ErrorCount count = { 0, 0 };
+
+    for (const char * c = charString; *c; c++)
+    {
+      const SDFF_Glyph * glyph = font.getGlyph(*c);
+
+      if (!glyph || FT_Load_Char(ftFace, *c, FT_LOAD_DEFAULT | FT_LOAD_IGNORE_TRANSFORM | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_RENDER | FT_LOAD_TARGET_MONO))
+        continue;
+
+      if (ftFace->glyph->bitmap.width && ftFace->glyph->bitmap.rows)
+        measureGlyph(atlas, *glyph, ftFace->glyph->bitmap, int(falloff * sourceFontSize), (float)sdfFontSize / sourceFontSize, count);
+    }
+
+    printf("%-10s %8d %10.3f %10.1f\n", filterNames[filter], sdfFontSize, 100.0 * count.wrong / glm::max(count.ink, 1L),
+           1000.0 * buildTime / Crosy::getPerformanceFrequency());
+  }
+
+  FT_Done_Face(ftFace);
+  FT_Done_FreeType(ftLibrary);
+
+  return 0;
+}
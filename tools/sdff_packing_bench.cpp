@@ -0,0 +1,121 @@
+// Time and occupancy of every packing strategy on synthetic glyph sets.
+// Glyph sizes imitate CJK ideographs at sdfFontSize 64 with falloff 0.125: mostly full em boxes with some narrower
+// and shorter ones, plus a few small punctuation marks. Occupancy is the glyph area over the atlas area,
+// for the bounds of the placed glyphs and for the power of two atlas composeTexture makes of them.
+// The densest packing runs on all hardware threads.
+//
+// Usage: sdff_packing_bench [glyph counts...]
+// Built by proj/vs14/SDFFPackingBench.vcxproj of the SDFFBuilder solution into bin, next to the default font.
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "static_headers.h"
+
+#include "sdff_packer.h"
+#include "sdff_thread_pool.h"
+#include "Crosy.h"
+
+static const char * packingNames[] = { "free rects", "skyline", "densest" };
+
+
+static int powerOfTwo(int value)
+{
+  int result = 1;
+
+  while (result < value)
+    result *= 2;
+
+  return result;
+}
+
+
+// the same sizes for the same count, sorted by decreasing area the way composeTexture packs them
+static void createGlyphRects(int count, SDFF_Packer::RectVector & rects)
+{
+  unsigned int seed = 12345;
+  rects.clear();
+
+  for (int i = 0; i < count; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    int kind = (seed >> 16) % 100;
+    seed = seed * 1103515245 + 12345;
+    int jitter = (seed >> 16) % 9;
+    SDFF_Packer::Rect rect = { 0, 0, 0, 0 };
+
+    if (kind < 80)
+    {
+      rect.width = 70 + jitter;
+      rect.height = 70 + (jitter * 7) % 9;
+    }
+    else if (kind < 95)
+    {
+      rect.width = 40 + jitter * 3;
+      rect.height = 60 + jitter * 2;
+    }
+    else
+    {
+      rect.width = 20 + jitter;
+      rect.height = 20 + (jitter * 5) % 9;
+    }
+
+    rects.push_back(rect);
+  }
+
+  std::stable_sort(rects.begin(), rects.end(), [](const SDFF_Packer::Rect & a, const SDFF_Packer::Rect & b) { return a.width * a.height > b.width * b.height; });
+}
+
+
+int main(int argc, char ** argv)
+{
+  std::vector<int> glyphCounts;
+
+  for (int i = 1; i < argc; i++)
+    glyphCounts.push_back(atoi(argv[i]));
+
+  if (glyphCounts.empty())
+  {
+    glyphCounts.push_back(1000);
+    glyphCounts.push_back(10000);
+    glyphCounts.push_back(50000);
+  }
+
+  SDFF_ThreadPool threadPool;
+  threadPool.init(glm::max((int)std::thread::hardware_concurrency(), 1));
+  printf("%8s %-12s%12s%14s%12s%14s%12s\n", "glyphs", "packing", "time, ms", "bounds", "occupancy", "atlas", "occupancy");
+
+  for (int countIndex = 0; countIndex < (int)glyphCounts.size(); countIndex++)
+  for (int packing = SDFF_PACKING_FREE_RECTS; packing <= SDFF_PACKING_DENSEST; packing++)
+  {
+    SDFF_Packer::RectVector rects;
+    createGlyphRects(glyphCounts[countIndex], rects);
+    double glyphArea = 0.0;
+
+    for (int i = 0; i < (int)rects.size(); i++)
+      glyphArea += (double)rects[i].width * rects[i].height;
+
+    std::unique_ptr<SDFF_Packer> packer(SDFF_Packer::create((SDFF_Packing)packing, &threadPool));
+    int width;
+    int height;
+    uint64_t startTime = Crosy::getPerformanceCounter();
+    packer->pack(rects, true, width, height);
+    uint64_t packTime = Crosy::getPerformanceCounter() - startTime;
+
+    // placed glyphs must stay inside the bounds and never overlap
+    for (int i = 0; i < (int)rects.size(); i++)
+    {
+      assert(rects[i].left >= 0 && rects[i].top >= 0 && rects[i].left + rects[i].width <= width && rects[i].top + rects[i].height <= height);
+
+      for (int j = i + 1; j < (int)rects.size() && rects.size() <= 10000; j++)
+        assert(!rects[i].intersect(rects[j]));
+    }
+
+    char bounds[32];
+    char atlas[32];
+    snprintf(bounds, sizeof(bounds), "%dx%d", width, height);
+    snprintf(atlas, sizeof(atlas), "%dx%d", powerOfTwo(width), powerOfTwo(height));
+    printf("%8d %-12s%12.1f%14s%11.1f%%%14s%11.1f%%\n", glyphCounts[countIndex], packingNames[packing], 1000.0 * packTime / Crosy::getPerformanceFrequency(),
+           bounds, 100.0 * glyphArea / ((double)width * height), atlas, 100.0 * glyphArea / ((double)powerOfTwo(width) * powerOfTwo(height)));
+  }
+
+  return 0;
+}
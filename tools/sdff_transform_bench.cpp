@@ -0,0 +1,114 @@
+// Time and error of every mono distance transform engine over a fixed glyph corpus.
+// Engines transform the whole padded bitmap of every glyph with a band just over the falloff, errors are measured
+// against the unbanded brute force reference on distances clamped to the falloff, beyond which the quantized field
+// saturates anyway.
+// Build time is the whole builder with one thread, where Meijster runs fused with downsampling.
+//
+// Usage: sdff_transform_bench [font file] [source size]
+// Built by proj/vs14/SDFFTransformBench.vcxproj of the SDFFBuilder solution into bin, next to the default font.
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "static_headers.h"
+
+#include "sdff_builder.h"
+#include "Crosy.h"
+
+#include FT_BITMAP_H
+
+static const char * transformNames[] = { "meijster", "felzenszwalb", "8ssedt", "jump flood", "brute force" };
+static const char * charString = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz'";
+static const float falloff = 0.125f;
+
+
+static double milliseconds(uint64_t counter)
+{
+  return counter * 1000.0 / Crosy::getPerformanceFrequency();
+}
+
+
+int main(int argc, char ** argv)
+{
+  const char * fontFileName = argc > 1 ? argv[1] : "Montserrat-Bold.otf";
+  int sourceSize = argc > 2 ? atoi(argv[2]) : 512;
+  int srcFalloff = int(falloff * sourceSize);
+
+  FT_Library ftLibrary;
+  FT_Face ftFace;
+  FT_Init_FreeType(&ftLibrary);
+
+  if (FT_New_Face(ftLibrary, fontFileName, 0, &ftFace) || FT_Set_Char_Size(ftFace, sourceSize * 64, sourceSize * 64, 64, 64))
+  {
+    printf("Can't open %s\n", fontFileName);
+    return 1;
+  }
+
+  // the corpus is rendered once, every engine transforms the same bitmaps
+  std::vector<FT_Bitmap> bitmaps;
+
+  for (const char * c = charString; *c; c++)
+  {
+    FT_Load_Char(ftFace, *c, FT_LOAD_DEFAULT | FT_LOAD_IGNORE_TRANSFORM | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_RENDER | FT_LOAD_TARGET_MONO);
+    FT_Bitmap bitmap;
+    FT_Bitmap_Init(&bitmap);
+    FT_Bitmap_Copy(ftLibrary, &ftFace->glyph->bitmap, &bitmap);
+
+    if (bitmap.width && bitmap.rows)
+      bitmaps.push_back(bitmap);
+  }
+
+  std::vector<SDFF_DistanceTransform::DistanceFieldVector> references(bitmaps.size());
+  std::unique_ptr<SDFF_DistanceTransform> reference(SDFF_DistanceTransform::create(SDFF_TRANSFORM_BRUTE_FORCE));
+
+  for (size_t i = 0; i < bitmaps.size(); i++)
+    reference->createSdf(bitmaps[i], srcFalloff, 0, references[i]);
+
+  printf("%zu glyphs at source size %d, falloff %d px\n", bitmaps.size(), sourceSize, srcFalloff);
+  printf("%-14s%16s%16s%16s%12s\n", "engine", "transform ms", "max error px", "mean error px", "build ms");
+
+  for (int transform = SDFF_TRANSFORM_MEIJSTER; transform <= SDFF_TRANSFORM_BRUTE_FORCE; transform++)
+  {
+    std::unique_ptr<SDFF_DistanceTransform> engine(SDFF_DistanceTransform::create((SDFF_Transform)transform));
+    SDFF_DistanceTransform::DistanceFieldVector sdf;
+    uint64_t transformTime = 0;
+    float maxError = 0;
+    double errorSum = 0;
+    long pixelCount = 0;
+
+    for (size_t i = 0; i < bitmaps.size(); i++)
+    {
+      uint64_t startTime = Crosy::getPerformanceCounter();
+      engine->createSdf(bitmaps[i], srcFalloff, srcFalloff + 1, sdf);
+      transformTime += Crosy::getPerformanceCounter() - startTime;
+
+      for (size_t p = 0; p < sdf.size(); p++)
+      {
+        float error = glm::abs(glm::clamp(sdf[p], -(float)srcFalloff, (float)srcFalloff) - glm::clamp(references[i][p], -(float)srcFalloff, (float)srcFalloff));
+        maxError = glm::max(maxError, error);
+        errorSum += error;
+      }
+
+      pixelCount += (long)sdf.size();
+    }
+
+    SDFF_Builder builder;
+    SDFF_Options options;
+    options.threadCount = 1;
+    options.transform = (SDFF_Transform)transform;
+    builder.init(sourceSize, 64, falloff, options);
+    SDFF_Font font;
+    builder.addFont(fontFileName, 0, &font);
+    uint64_t startTime = Crosy::getPerformanceCounter();
+    builder.addChars(font, charString);
+    uint64_t buildTime = Crosy::getPerformanceCounter() - startTime;
+
+    printf("%-14s%16.1f%16.3f%16.5f%12.1f\n", transformNames[transform], milliseconds(transformTime), maxError, errorSum / pixelCount, milliseconds(buildTime));
+  }
+
+  for (size_t i = 0; i < bitmaps.size(); i++)
+    FT_Bitmap_Done(ftLibrary, &bitmaps[i]);
+
+  FT_Done_Face(ftFace);
+  FT_Done_FreeType(ftLibrary);
+
+  return 0;
+}